@@ -1,5 +1,6 @@
 #ifndef KUDZUKERNEL_HARDWARE_PINOUT_HPP
 #define KUDZUKERNEL_HARDWARE_PINOUT_HPP
+#include "sdkconfig.h"
 
 /**
  * The built-in led
@@ -46,6 +47,13 @@
 #define   PIN_INT_EXTERNAL  GPIO_NUM_34
 #define   PIN_INT_RFM       GPIO_NUM_35
 
+/**
+ * IMU interrupt, only on boards where it's wired to the external interrupt
+ */
+#ifdef CONFIG_IMU_INT_WAKEUP
+#define   PIN_INT_IMU       PIN_INT_EXTERNAL
+#endif
+
 /**
  * Power management
  */
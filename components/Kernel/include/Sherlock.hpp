@@ -39,25 +39,29 @@
 #define TRACE(ACTION) \
   sherlock_trace( ACTION & 0x7F )
 
+/**
+ * The TRACE_LOG* macros are compiled out entirely (including the trace
+ * mark) when their level is above LOG_LOCAL_LEVEL.
+ */
 #define TRACE_LOGE( tag, format, ... ) \
-  { sherlock_trace(0x84); \
-    ESP_LOG_LEVEL_LOCAL(ESP_LOG_ERROR,   tag, format, ##__VA_ARGS__); }
+  { if (LOG_LOCAL_LEVEL >= ESP_LOG_ERROR) { sherlock_trace(0x84); \
+    ESP_LOG_LEVEL_LOCAL(ESP_LOG_ERROR,   tag, format, ##__VA_ARGS__); } }
 
 #define TRACE_LOGW( tag, format, ... ) \
-  { sherlock_trace(0x83); \
-    ESP_LOG_LEVEL_LOCAL(ESP_LOG_WARN,   tag, format, ##__VA_ARGS__); }
+  { if (LOG_LOCAL_LEVEL >= ESP_LOG_WARN) { sherlock_trace(0x83); \
+    ESP_LOG_LEVEL_LOCAL(ESP_LOG_WARN,   tag, format, ##__VA_ARGS__); } }
 
 #define TRACE_LOGI( tag, format, ... ) \
-  { sherlock_trace(0x82); \
-    ESP_LOG_LEVEL_LOCAL(ESP_LOG_INFO,   tag, format, ##__VA_ARGS__); }
+  { if (LOG_LOCAL_LEVEL >= ESP_LOG_INFO) { sherlock_trace(0x82); \
+    ESP_LOG_LEVEL_LOCAL(ESP_LOG_INFO,   tag, format, ##__VA_ARGS__); } }
 
 #define TRACE_LOGD( tag, format, ... ) \
-  { sherlock_trace(0x81); \
-    ESP_LOG_LEVEL_LOCAL(ESP_LOG_DEBUG,   tag, "CPU %d: " format, xPortGetCoreID(), ##__VA_ARGS__); }
+  { if (LOG_LOCAL_LEVEL >= ESP_LOG_DEBUG) { sherlock_trace(0x81); \
+    ESP_LOG_LEVEL_LOCAL(ESP_LOG_DEBUG,   tag, "CPU %d: " format, xPortGetCoreID(), ##__VA_ARGS__); } }
 
 #define TRACE_LOGV( tag, format, ... ) \
-  { sherlock_trace(0x80); \
-    ESP_LOG_LEVEL_LOCAL(ESP_LOG_VERBOSE,   tag, format, ##__VA_ARGS__); }
+  { if (LOG_LOCAL_LEVEL >= ESP_LOG_VERBOSE) { sherlock_trace(0x80); \
+    ESP_LOG_LEVEL_LOCAL(ESP_LOG_VERBOSE,   tag, format, ##__VA_ARGS__); } }
 
 #define S_LOGI(TAG, FORMAT, ...) \
   sherlock_trace(); \
@@ -226,6 +226,16 @@ class MPU
     esp_err_t writeBytes(uint8_t regAddr, size_t length, const uint8_t* data);
     esp_err_t registerDump(uint8_t start = 0x0, uint8_t end = 0x7F);
     //! \}
+    //! \name Register shadow
+    //! Configuration registers are mirrored in RAM once read or written,
+    //! so reads and read-modify-writes on them skip the bus.
+    //! \{
+    esp_err_t refreshShadow();
+    void invalidateShadow();
+    void beginWriteBatch();
+    esp_err_t commitWriteBatch();
+    class WriteBatch;
+    //! \}
     //! \name Sensor readings
     //! \{
     esp_err_t acceleration(raw_axes_t* accel);
@@ -249,10 +259,38 @@ class MPU
     esp_err_t getBiases(accel_fs_t accelFS, gyro_fs_t gyroFS, raw_axes_t* accelBias, raw_axes_t* gyroBias,
                         bool selftest);
 
-    mpu_bus_t* bus;         /*!< Communication bus pointer, I2C / SPI */
-    mpu_addr_handle_t addr; /*!< I2C address / SPI device handle */
-    uint8_t buffer[16];     /*!< Commom buffer for temporary data */
-    esp_err_t err;          /*!< Holds last error code */
+    bool shadowHit(uint8_t regAddr, size_t length);
+    void shadowStore(uint8_t regAddr, size_t length, const uint8_t* data);
+    esp_err_t shadowFlush();
+
+    mpu_bus_t* bus;           /*!< Communication bus pointer, I2C / SPI */
+    mpu_addr_handle_t addr;   /*!< I2C address / SPI device handle */
+    uint8_t buffer[16];       /*!< Commom buffer for temporary data */
+    esp_err_t err;            /*!< Holds last error code */
+    uint8_t shadow[128];      /*!< RAM copy of the configuration registers */
+    uint32_t shadowValid[4];  /*!< Bitmap of registers held in `shadow` */
+    uint32_t shadowDirty[4];  /*!< Bitmap of registers waiting for commitWriteBatch() */
+    bool batching;            /*!< Writes to shadowed registers are deferred */
+};
+
+/**
+ * @brief Batch the writes to shadowed registers for the lifetime of a scope.
+ *
+ * If the scope is left without commit(), e.g. on an error path, the deferred writes
+ * are dropped along with the shadow and batch mode is left.
+ */
+class MPU::WriteBatch
+{
+ public:
+    explicit WriteBatch(MPU& mpu);
+    ~WriteBatch();
+    WriteBatch(const WriteBatch&) = delete;
+    WriteBatch& operator=(const WriteBatch&) = delete;
+    esp_err_t commit();
+
+ private:
+    MPU& mpu;
+    bool committed;
 };
 
 }  // namespace mpud
@@ -274,7 +312,10 @@ inline MPU::MPU(mpu_bus_t& bus) : MPU(bus, MPU_DEFAULT_ADDR_HANDLE) {}
  * @param bus Bus protocol object of type `I2Cbus` or `SPIbus`.
  * @param addr I2C address (`mpu_i2caddr_t`) or SPI device handle (`spi_device_handle_t`).
  */
-inline MPU::MPU(mpu_bus_t& bus, mpu_addr_handle_t addr) : bus{&bus}, addr{addr}, buffer{0}, err{ESP_OK} {}
+inline MPU::MPU(mpu_bus_t& bus, mpu_addr_handle_t addr)
+    : bus{&bus}, addr{addr}, buffer{0}, err{ESP_OK}, shadow{0}, shadowValid{0}, shadowDirty{0}, batching{false}
+{
+}
 /** Default Destructor, does nothing. */
 inline MPU::~MPU() = default;
 /**
@@ -284,6 +325,7 @@ inline MPU::~MPU() = default;
 inline MPU& MPU::setBus(mpu_bus_t& bus)
 {
     this->bus = &bus;
+    invalidateShadow();
     return *this;
 }
 /**
@@ -300,6 +342,7 @@ inline mpu_bus_t& MPU::getBus()
 inline MPU& MPU::setAddr(mpu_addr_handle_t addr)
 {
     this->addr = addr;
+    invalidateShadow();
     return *this;
 }
 /**
@@ -309,6 +352,22 @@ inline mpu_addr_handle_t MPU::getAddr()
 {
     return addr;
 }
+/*! Enter batch mode. */
+inline MPU::WriteBatch::WriteBatch(MPU& mpu) : mpu{mpu}, committed{false}
+{
+    mpu.beginWriteBatch();
+}
+/*! Drop the deferred writes if they were not committed. */
+inline MPU::WriteBatch::~WriteBatch()
+{
+    if (!committed) mpu.invalidateShadow();
+}
+/*! Write the deferred registers and leave batch mode. */
+inline esp_err_t MPU::WriteBatch::commit()
+{
+    committed = true;
+    return mpu.commitWriteBatch();
+}
 /*! Return last error code. */
 inline esp_err_t MPU::lastError()
 {
@@ -317,42 +376,41 @@ inline esp_err_t MPU::lastError()
 /*! Read a single bit from a register*/
 inline esp_err_t MPU::readBit(uint8_t regAddr, uint8_t bitNum, uint8_t* data)
 {
-    return err = bus->readBit(addr, regAddr, bitNum, data);
+    return readBits(regAddr, bitNum, 1, data);
 }
 /*! Read a range of bits from a register */
 inline esp_err_t MPU::readBits(uint8_t regAddr, uint8_t bitStart, uint8_t length, uint8_t* data)
 {
-    return err = bus->readBits(addr, regAddr, bitStart, length, data);
+    uint8_t value;
+    if (readByte(regAddr, &value)) return err;
+    const uint8_t shift = bitStart - length + 1;
+    *data               = (value >> shift) & ((1 << length) - 1);
+    return err;
 }
 /*! Read a single register */
 inline esp_err_t MPU::readByte(uint8_t regAddr, uint8_t* data)
 {
-    return err = bus->readByte(addr, regAddr, data);
-}
-/*! Read data from sequence of registers */
-inline esp_err_t MPU::readBytes(uint8_t regAddr, size_t length, uint8_t* data)
-{
-    return err = bus->readBytes(addr, regAddr, length, data);
+    return readBytes(regAddr, 1, data);
 }
 /*! Write a single bit to a register */
 inline esp_err_t MPU::writeBit(uint8_t regAddr, uint8_t bitNum, uint8_t data)
 {
-    return err = bus->writeBit(addr, regAddr, bitNum, data);
+    return writeBits(regAddr, bitNum, 1, data);
 }
 /*! Write a range of bits to a register */
 inline esp_err_t MPU::writeBits(uint8_t regAddr, uint8_t bitStart, uint8_t length, uint8_t data)
 {
-    return err = bus->writeBits(addr, regAddr, bitStart, length, data);
+    uint8_t value;
+    if (readByte(regAddr, &value)) return err;
+    const uint8_t shift = bitStart - length + 1;
+    const uint8_t mask  = ((1 << length) - 1) << shift;
+    value               = (value & ~mask) | ((data << shift) & mask);
+    return writeByte(regAddr, value);
 }
 /*! Write a value to a register */
 inline esp_err_t MPU::writeByte(uint8_t regAddr, uint8_t data)
 {
-    return err = bus->writeByte(addr, regAddr, data);
-}
-/*! Write a sequence to data to a sequence of registers */
-inline esp_err_t MPU::writeBytes(uint8_t regAddr, size_t length, const uint8_t* data)
-{
-    return err = bus->writeBytes(addr, regAddr, length, data);
+    return writeBytes(regAddr, 1, &data);
 }
 
 }  // namespace mpud
@@ -13,6 +13,7 @@
 #define _MPU_MATH_HPP_
 
 #include <math.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "mpu/types.hpp"
 #include "sdkconfig.h"
@@ -96,6 +97,113 @@ inline float_axes_t gyroRadPerSec(const raw_axes_t& raw_axes, const gyro_fs_t fs
     return axes;
 }
 
+// ==============================
+// Batch conversion of FIFO data
+// ==============================
+// The kernels below work straight on big-endian FIFO bytes. `stride` is the
+// size of one FIFO packet (e.g. 12 for accel + gyro) and `src` points to the
+// first byte of the axes to convert inside the first packet, so the same data
+// block can be walked once for accel (src) and once for gyro (src + 6).
+
+inline int16_t fifoAxis(const uint8_t* p)
+{
+    return static_cast<int16_t>((p[0] << 8) | p[1]);
+}
+
+/**
+ * @brief Byte swap `count` packed FIFO axes into raw axes.
+ */
+inline void rawAxesBatch(const uint8_t* src, size_t stride, size_t count, raw_axes_t* dst)
+{
+    for (size_t i = 0; i < count; i++, src += stride) {
+        dst[i].x = fifoAxis(src);
+        dst[i].y = fifoAxis(src + 2);
+        dst[i].z = fifoAxis(src + 4);
+    }
+}
+
+/**
+ * @brief Sum `count` packed FIFO axes into `sum[3]` (not cleared).
+ * @note A whole FIFO (4kB max) can never overflow the 32-bit sums.
+ */
+inline void sumAxesBatch(const uint8_t* src, size_t stride, size_t count, int32_t* sum)
+{
+    int32_t x = 0, y = 0, z = 0;
+    for (size_t i = 0; i < count; i++, src += stride) {
+        x += fifoAxis(src);
+        y += fifoAxis(src + 2);
+        z += fifoAxis(src + 4);
+    }
+    sum[0] += x;
+    sum[1] += y;
+    sum[2] += z;
+}
+
+/**
+ * @brief Byte swap, subtract `bias` and scale by `resolution` in one pass.
+ */
+inline void scaleAxesBatch(const uint8_t* src, size_t stride, size_t count, const raw_axes_t& bias,
+                           const float resolution, float_axes_t* dst)
+{
+    for (size_t i = 0; i < count; i++, src += stride) {
+        dst[i].x = (fifoAxis(src) - bias.x) * resolution;
+        dst[i].y = (fifoAxis(src + 2) - bias.y) * resolution;
+        dst[i].z = (fifoAxis(src + 4) - bias.z) * resolution;
+    }
+}
+
+inline void accelGravityBatch(const uint8_t* src, size_t stride, size_t count, const raw_axes_t& bias,
+                              const accel_fs_t fs, float_axes_t* dst)
+{
+    scaleAxesBatch(src, stride, count, bias, accelResolution(fs), dst);
+}
+
+inline void gyroDegPerSecBatch(const uint8_t* src, size_t stride, size_t count, const raw_axes_t& bias,
+                               const gyro_fs_t fs, float_axes_t* dst)
+{
+    scaleAxesBatch(src, stride, count, bias, gyroResolution(fs), dst);
+}
+
+inline void gyroRadPerSecBatch(const uint8_t* src, size_t stride, size_t count, const raw_axes_t& bias,
+                               const gyro_fs_t fs, float_axes_t* dst)
+{
+    scaleAxesBatch(src, stride, count, bias, (M_PI / 180) * gyroResolution(fs), dst);
+}
+
+/**
+ * @brief Fixed-point variant of accelGravityBatch(), output in Q16.16 (g).
+ *
+ * Accel sensitivity is a power of two (16384 LSB/g at 2g), so the scale is a
+ * plain shift and no FPU work is needed. Results follow accelSensitivity(),
+ * which differs from accelResolution() by the INT16_MAX vs 32768 rounding.
+ */
+inline void accelGravityBatchQ16(const uint8_t* src, size_t stride, size_t count, const raw_axes_t& bias,
+                                 const accel_fs_t fs, int32_t* dst)
+{
+    const int shift = 2 + fs;  // 2^16 / (16384 >> fs)
+    for (size_t i = 0; i < count; i++, src += stride, dst += 3) {
+        dst[0] = (fifoAxis(src) - bias.x) * (1 << shift);
+        dst[1] = (fifoAxis(src + 2) - bias.y) * (1 << shift);
+        dst[2] = (fifoAxis(src + 4) - bias.z) * (1 << shift);
+    }
+}
+
+/**
+ * @brief Fixed-point variant of gyroDegPerSecBatch(), output in Q16.16 (º/s).
+ * @note Results follow gyroSensitivity(), see accelGravityBatchQ16().
+ */
+inline void gyroDegPerSecBatchQ16(const uint8_t* src, size_t stride, size_t count, const raw_axes_t& bias,
+                                  const gyro_fs_t fs, int32_t* dst)
+{
+    // 2^16 / gyroSensitivity(fs), at most ~4002 so the product fits in 32 bits
+    const int32_t factor = ((65536 << fs) + 65) / 131;
+    for (size_t i = 0; i < count; i++, src += stride, dst += 3) {
+        dst[0] = (fifoAxis(src) - bias.x) * factor;
+        dst[1] = (fifoAxis(src + 2) - bias.y) * factor;
+        dst[2] = (fifoAxis(src + 4) - bias.z) * factor;
+    }
+}
+
 #if defined CONFIG_MPU6500 || defined CONFIG_MPU9250
 constexpr int16_t kRoomTempOffset = 0;        // LSB
 constexpr float kCelsiusOffset    = 21.f;     // ºC
@@ -51,6 +51,8 @@ esp_err_t MPU::initialize()
 {
     // reset device (wait a little to clear all registers)
     if (MPU_ERR_CHECK(reset())) return err;
+    // load the configuration registers once, the read-modify-writes below are served from RAM
+    if (MPU_ERR_CHECK(refreshShadow())) return err;
     // wake-up the device (power on-reset state is asleep for some models)
     if (MPU_ERR_CHECK(setSleep(false))) return err;
         // disable MPU's I2C slave module when using SPI
@@ -60,6 +62,10 @@ esp_err_t MPU::initialize()
     // set clock source to gyro PLL which is better than internal clock
     if (MPU_ERR_CHECK(setClockSource(CLOCK_PLL))) return err;
 
+    // coalesce the configuration below into as few bursts as possible,
+    // an early return drops the batch instead of leaving it open
+    WriteBatch batch(*this);
+
 #ifdef CONFIG_MPU6500
     // MPU6500 / MPU9250 share 4kB of memory between the DMP and the FIFO. Since the
     // first 3kB are needed by the DMP, we'll use the last 1kB for the FIFO.
@@ -85,6 +91,7 @@ esp_err_t MPU::initialize()
 
     // set sample rate to 100Hz
     if (MPU_ERR_CHECK(setSampleRate(100))) return err;
+    if (MPU_ERR_CHECK(batch.commit())) return err;
     MPU_LOGI("Initialization complete");
     return err;
 }
@@ -1680,6 +1687,163 @@ bool MPU::getFsyncEnabled()
     return buffer[0];
 }
 
+/**
+ * @brief Registers that only change when written by the host.
+ *
+ * Offsets, sample rate, sensor and interrupt configuration, Aux I2C slaves 0-3,
+ * MOT_DETECT_CTRL / ACCEL_INTEL_CTRL, USER_CTRL and power management. Status, data,
+ * FIFO, DMP memory and Slave 4 registers are always accessed on the bus.
+ */
+static inline bool isShadowed(uint8_t regAddr)
+{
+    return (regAddr >= regs::XG_OFFSET_H && regAddr <= regs::I2C_SLV3_CTRL) || regAddr == regs::INT_PIN_CONFIG ||
+           regAddr == regs::INT_ENABLE || (regAddr >= regs::I2C_SLV0_DO && regAddr <= regs::I2C_MST_DELAY_CRTL) ||
+           (regAddr > regs::SIGNAL_PATH_RESET && regAddr <= regs::PWR_MGMT2);
+}
+
+/**
+ * @brief Bits that trigger an action and clear themselves once done.
+ */
+static inline uint8_t selfClearingBits(uint8_t regAddr)
+{
+    if (regAddr == regs::USER_CTRL) {
+        return (1 << regs::USERCTRL_DMP_RESET_BIT) | (1 << regs::USERCTRL_FIFO_RESET_BIT) |
+               (1 << regs::USERCTRL_I2C_MST_RESET_BIT) | (1 << regs::USERCTRL_SIG_COND_RESET_BIT);
+    }
+    if (regAddr == regs::PWR_MGMT1) return (1 << regs::PWR1_DEVICE_RESET_BIT);
+    return 0;
+}
+
+/*! Read data from sequence of registers, served from the shadow when possible */
+esp_err_t MPU::readBytes(uint8_t regAddr, size_t length, uint8_t* data)
+{
+    if (shadowHit(regAddr, length)) {
+        memcpy(data, &shadow[regAddr], length);
+        return err = ESP_OK;
+    }
+    // keep the order of the deferred writes with respect to this read
+    if (shadowFlush()) return err;
+    if ((err = bus->readBytes(addr, regAddr, length, data))) return err;
+    shadowStore(regAddr, length, data);
+    return err;
+}
+
+/*! Write a sequence to data to a sequence of registers */
+esp_err_t MPU::writeBytes(uint8_t regAddr, size_t length, const uint8_t* data)
+{
+    bool deferrable = batching;
+    bool resets     = false;
+    for (size_t i = 0; i < length; i++) {
+        const uint8_t reg = regAddr + i;
+        if (!isShadowed(reg) || (data[i] & selfClearingBits(reg))) deferrable = false;
+        if (reg == regs::PWR_MGMT1 && (data[i] & (1 << regs::PWR1_DEVICE_RESET_BIT))) resets = true;
+    }
+    if (deferrable) {
+        shadowStore(regAddr, length, data);
+        for (size_t i = 0; i < length; i++) {
+            const uint8_t reg = regAddr + i;
+            shadowDirty[reg >> 5] |= (1 << (reg & 0x1F));
+        }
+        return err = ESP_OK;
+    }
+    if (shadowFlush()) return err;
+    if ((err = bus->writeBytes(addr, regAddr, length, data))) return err;
+    if (resets) {
+        invalidateShadow();
+    }
+    else {
+        shadowStore(regAddr, length, data);
+    }
+    return err;
+}
+
+/**
+ * @brief Load all shadowed registers from the device in a few burst reads.
+ */
+esp_err_t MPU::refreshShadow()
+{
+    static constexpr uint8_t kRanges[][2] = {{regs::XG_OFFSET_H, regs::I2C_SLV3_CTRL},
+                                             {regs::INT_PIN_CONFIG, regs::INT_ENABLE},
+                                             {regs::I2C_SLV0_DO, regs::PWR_MGMT2}};
+    uint8_t data[32];
+    if (shadowFlush()) return err;
+    for (const auto& range : kRanges) {
+        const size_t length = range[1] - range[0] + 1;
+        if ((err = bus->readBytes(addr, range[0], length, data))) return err;
+        shadowStore(range[0], length, data);
+    }
+    return err;
+}
+
+/**
+ * @brief Forget the shadow, next accesses go to the bus.
+ * @note Pending batched writes are dropped and batch mode is left, as after a reset.
+ */
+void MPU::invalidateShadow()
+{
+    batching = false;
+    memset(shadowValid, 0, sizeof(shadowValid));
+    memset(shadowDirty, 0, sizeof(shadowDirty));
+}
+
+/**
+ * @brief Defer writes to shadowed registers until commitWriteBatch().
+ *
+ * Accesses to other registers, and writes that trigger an action (resets) flush the
+ * pending writes first, so the device sees every access in a consistent order.
+ * Contiguous dirty registers are written in a single burst.
+ */
+void MPU::beginWriteBatch()
+{
+    batching = true;
+}
+
+/**
+ * @brief Write all deferred registers and leave batch mode.
+ */
+esp_err_t MPU::commitWriteBatch()
+{
+    batching = false;
+    return shadowFlush();
+}
+
+bool MPU::shadowHit(uint8_t regAddr, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        const uint8_t reg = regAddr + i;
+        if (reg >= sizeof(shadow) || !(shadowValid[reg >> 5] & (1 << (reg & 0x1F)))) return false;
+    }
+    return true;
+}
+
+void MPU::shadowStore(uint8_t regAddr, size_t length, const uint8_t* data)
+{
+    for (size_t i = 0; i < length; i++) {
+        const uint8_t reg = regAddr + i;
+        if (reg >= sizeof(shadow) || !isShadowed(reg)) continue;
+        shadow[reg] = data[i] & ~selfClearingBits(reg);
+        shadowValid[reg >> 5] |= (1 << (reg & 0x1F));
+    }
+}
+
+/*! Write every run of contiguous dirty registers with one burst */
+esp_err_t MPU::shadowFlush()
+{
+    err = ESP_OK;
+    size_t reg = 0;
+    while (reg < sizeof(shadow)) {
+        if (!(shadowDirty[reg >> 5] & (1 << (reg & 0x1F)))) {
+            reg++;
+            continue;
+        }
+        size_t end = reg;
+        while (end < sizeof(shadow) && (shadowDirty[end >> 5] & (1 << (end & 0x1F)))) end++;
+        if ((err = bus->writeBytes(addr, reg, end - reg, &shadow[reg]))) return err;
+        for (; reg < end; reg++) shadowDirty[reg >> 5] &= ~(1 << (reg & 0x1F));
+    }
+    return err;
+}
+
 /**
  * @brief Print out register values for debugging purposes.
  * @param start first register number.
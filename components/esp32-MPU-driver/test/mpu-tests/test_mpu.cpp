@@ -13,6 +13,8 @@
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
 #include "esp_intr_alloc.h"
+#include "esp_system.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "unity.h"
@@ -78,6 +80,25 @@ class MPU : public mpud::MPU {
         this->bus->close();
         isBusInit = false;
     }
+
+    /*! Point the accesses to a missing device to inject bus errors, without touching the shadow */
+    void setBusBroken(bool broken) {
+        if (broken) {
+            goodAddr = this->addr;
+            #ifdef CONFIG_MPU_I2C
+            this->addr = (mpud::mpu_addr_handle_t) 0x7F;
+            #elif CONFIG_MPU_SPI
+            this->addr = nullptr;
+            #endif
+        } else {
+            this->addr = goodAddr;
+        }
+    }
+
+    bool inWriteBatch() const { return this->batching; }
+
+ private:
+    mpud::mpu_addr_handle_t goodAddr = mpud::MPU_DEFAULT_ADDR_HANDLE;
 };
 using MPU_t = MPU;
 }  // namespace test
@@ -898,3 +919,122 @@ TEST_CASE("MPU compass configuration", "[MPU]")
     }
 }
 #endif
+
+/**
+ * Batch conversion kernels: check equivalence with the per-sample conversions
+ * and compare throughput over a full 1kB FIFO of accel + gyro packets.
+ */
+TEST_CASE("MPU batch FIFO conversion", "[MPU]")
+{
+    constexpr size_t kPacketSize = 12;
+    constexpr size_t kCount = 1024 / kPacketSize;
+    static uint8_t fifo[kCount * kPacketSize];
+    static mpud::raw_axes_t accelRaw[kCount], gyroRaw[kCount];
+    static mpud::float_axes_t batch[kCount], single[kCount];
+    static int32_t fixed[kCount * 3];
+    // keep the samples within +-16384 so that removing the bias fits in an int16_t
+    for (size_t i = 0; i < sizeof(fifo); i++) fifo[i] = (i & 1) ? esp_random() : ((int8_t) esp_random() >> 1);
+    mpud::raw_axes_t bias;
+    bias.x = 12; bias.y = -34; bias.z = 56;
+    for (size_t i = 0; i < kCount; i++) {
+        const uint8_t* pkt = &fifo[i * kPacketSize];
+        for (int j = 0; j < 3; j++) {
+            accelRaw[i][j] = (int16_t)(pkt[2 * j] << 8 | pkt[2 * j + 1]) - bias[j];
+            gyroRaw[i][j] = (int16_t)(pkt[6 + 2 * j] << 8 | pkt[6 + 2 * j + 1]) - bias[j];
+        }
+    }
+    // accel, per-sample reference
+    int64_t start = esp_timer_get_time();
+    for (size_t i = 0; i < kCount; i++) single[i] = mpud::accelGravity(accelRaw[i], mpud::ACCEL_FS_4G);
+    int64_t singleTime = esp_timer_get_time() - start;
+    // accel, batch
+    start = esp_timer_get_time();
+    mpud::accelGravityBatch(fifo, kPacketSize, kCount, bias, mpud::ACCEL_FS_4G, batch);
+    int64_t batchTime = esp_timer_get_time() - start;
+    start = esp_timer_get_time();
+    mpud::accelGravityBatchQ16(fifo, kPacketSize, kCount, bias, mpud::ACCEL_FS_4G, fixed);
+    int64_t fixedTime = esp_timer_get_time() - start;
+    printf("> %u packets: per-sample %lld us, batch %lld us, Q16 %lld us\n", (unsigned) kCount, singleTime, batchTime,
+           fixedTime);
+    for (size_t i = 0; i < kCount; i++) {
+        for (int j = 0; j < 3; j++) {
+            TEST_ASSERT_EQUAL_FLOAT(single[i][j], batch[i][j]);
+            TEST_ASSERT_FLOAT_WITHIN(0.001f, single[i][j], fixed[i * 3 + j] / 65536.f);
+        }
+    }
+    // gyro, walking the same packets from the gyro axes
+    mpud::gyroDegPerSecBatch(fifo + 6, kPacketSize, kCount, bias, mpud::GYRO_FS_500DPS, batch);
+    for (size_t i = 0; i < kCount; i++) {
+        single[i] = mpud::gyroDegPerSec(gyroRaw[i], mpud::GYRO_FS_500DPS);
+        for (int j = 0; j < 3; j++) TEST_ASSERT_EQUAL_FLOAT(single[i][j], batch[i][j]);
+    }
+    // the batch kernel folds the deg-to-rad factor into the resolution, allow for the rounding
+    mpud::gyroRadPerSecBatch(fifo + 6, kPacketSize, kCount, bias, mpud::GYRO_FS_500DPS, batch);
+    for (size_t i = 0; i < kCount; i++) {
+        single[i] = mpud::gyroRadPerSec(gyroRaw[i], mpud::GYRO_FS_500DPS);
+        for (int j = 0; j < 3; j++) TEST_ASSERT_FLOAT_WITHIN(1e-5f, single[i][j], batch[i][j]);
+    }
+    // sums used for averaging
+    int32_t sum[3] = {0, 0, 0};
+    mpud::sumAxesBatch(fifo + 6, kPacketSize, kCount, sum);
+    int32_t expected = 0;
+    for (size_t i = 0; i < kCount; i++) expected += gyroRaw[i].x + bias.x;
+    TEST_ASSERT_EQUAL_INT32(expected, sum[0]);
+}
+
+/**
+ * Register shadow: batched writes must reach the device and reset must drop the shadow.
+ */
+TEST_CASE("MPU register shadow", "[MPU]")
+{
+    test::MPU_t mpu;
+    TEST_ESP_OK( mpu.testConnection());
+    TEST_ESP_OK( mpu.initialize());
+    // batch a few contiguous configuration registers
+    mpu.beginWriteBatch();
+    TEST_ESP_OK( mpu.setSampleRate(250));
+    TEST_ESP_OK( mpu.setDigitalLowPassFilter(mpud::DLPF_98HZ));
+    TEST_ESP_OK( mpu.setGyroFullScale(mpud::GYRO_FS_2000DPS));
+    TEST_ESP_OK( mpu.setAccelFullScale(mpud::ACCEL_FS_16G));
+    TEST_ESP_OK( mpu.commitWriteBatch());
+    // read back from the device itself
+    mpu.invalidateShadow();
+    TEST_ASSERT_EQUAL_INT(250, mpu.getSampleRate());
+    TEST_ASSERT_EQUAL_INT(mpud::DLPF_98HZ, mpu.getDigitalLowPassFilter());
+    TEST_ASSERT_EQUAL_INT(mpud::GYRO_FS_2000DPS, mpu.getGyroFullScale());
+    TEST_ASSERT_EQUAL_INT(mpud::ACCEL_FS_16G, mpu.getAccelFullScale());
+    TEST_ESP_OK( mpu.lastError());
+    // reset restores the defaults, the shadow must not hide it
+    TEST_ESP_OK( mpu.reset());
+    TEST_ASSERT_EQUAL_INT(mpud::ACCEL_FS_2G, mpu.getAccelFullScale());
+    TEST_ASSERT_EQUAL_INT(mpud::GYRO_FS_250DPS, mpu.getGyroFullScale());
+    TEST_ESP_OK( mpu.lastError());
+}
+
+/**
+ * Write batch error path: a failure mid-batch must not leave the driver in batch mode.
+ */
+TEST_CASE("MPU write batch error path", "[MPU]")
+{
+    test::MPU_t mpu;
+    TEST_ESP_OK( mpu.testConnection());
+    TEST_ESP_OK( mpu.initialize());
+    TEST_ASSERT_FALSE( mpu.inWriteBatch());
+    {
+        mpud::MPU::WriteBatch batch(mpu);
+        TEST_ESP_OK( mpu.setSampleRate(250));
+        TEST_ASSERT_TRUE( mpu.inWriteBatch());
+        // WHO_AM_I is not shadowed, reading it flushes the batch to a missing device
+        mpu.setBusBroken(true);
+        uint8_t data;
+        TEST_ASSERT_NOT_EQUAL(ESP_OK, mpu.readByte(mpud::regs::WHO_AM_I, &data));
+        mpu.setBusBroken(false);
+        // bail out without commit, like initialize() does on errors
+    }
+    TEST_ASSERT_FALSE( mpu.inWriteBatch());
+    // writes reach the device again
+    TEST_ESP_OK( mpu.setSampleRate(250));
+    mpu.invalidateShadow();
+    TEST_ASSERT_EQUAL_INT(250, mpu.getSampleRate());
+    TEST_ESP_OK( mpu.lastError());
+}
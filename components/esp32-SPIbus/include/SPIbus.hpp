@@ -59,12 +59,16 @@ class SPI {
      * @param   miso_io_num     [GPIO number for Master-in Slave-out]
      * @param   miso_io_num     [GPIO number for clock line]
      * @param   max_transfer_sz [Maximum transfer size, in bytes. Defaults to 4094 if 0.]
+     * @param   dma_chan        [DMA channel (1 or 2) to use, or 0 for none.
+     *                           Without DMA a transaction is limited to 64 bytes.
+     *                           With DMA, buffers must be DMA-capable (internal RAM, word aligned).]
      * @return  - ESP_ERR_INVALID_ARG   if configuration is invalid
      *          - ESP_ERR_INVALID_STATE if host already is in use
      *          - ESP_ERR_NO_MEM        if out of memory
      *          - ESP_OK                on success
      * */
-    esp_err_t begin(int mosi_io_num, int miso_io_num, int sclk_io_num, int max_transfer_sz = SPI_MAX_DMA_LEN);
+    esp_err_t begin(int mosi_io_num, int miso_io_num, int sclk_io_num, int max_transfer_sz = SPI_MAX_DMA_LEN,
+                    int dma_chan = 0);
 
     /**
      * @brief   Free the SPI bus
@@ -81,6 +85,7 @@ class SPI {
      * @param   clock_speed_hz  [Clock speed, in Hz]
      * @param   cs_io_num       [ChipSelect GPIO pin for this device, or -1 if not used]
      * @param   handle          [Pointer to variable to hold the device handle]
+     * @param   queue_size      [Number of transactions that can be queued at once, see queueReadBytes()]
      * @param   dev_config      [SPI interface protocol config for the device (for more custom configs)]
      *                          @see driver/spi_master.h
      * @return  - ESP_ERR_INVALID_ARG   if parameter is invalid
@@ -88,7 +93,8 @@ class SPI {
      *          - ESP_ERR_NO_MEM        if out of memory
      *          - ESP_OK                on success
      * */
-    esp_err_t addDevice(uint8_t mode, uint32_t clock_speed_hz, int cs_io_num, spi_device_handle_t *handle);
+    esp_err_t addDevice(uint8_t mode, uint32_t clock_speed_hz, int cs_io_num, spi_device_handle_t *handle,
+                        int queue_size = 1);
     esp_err_t addDevice(spi_device_interface_config_t *dev_config, spi_device_handle_t *handle);
     esp_err_t removeDevice(spi_device_handle_t handle);
 
@@ -130,6 +136,37 @@ class SPI {
     esp_err_t readBits(spi_device_handle_t handle, uint8_t regAddr, uint8_t bitStart, uint8_t length, uint8_t *data);
     esp_err_t readByte(spi_device_handle_t handle, uint8_t regAddr, uint8_t *data);
     esp_err_t readBytes(spi_device_handle_t handle, uint8_t regAddr, size_t length, uint8_t *data);
+
+    /**
+     * *** QUEUED interface ***
+     * @brief  Queue a register read/write and return immediately, the transfer
+     *         runs in the background (by DMA if enabled in begin()).
+     *         The transaction and the data buffer are owned by the caller and
+     *         must stay valid until getTransResult() returned them. At most
+     *         `queue_size` (see addDevice()) transactions can be in flight.
+     *         A `post_cb` set through addDevice(dev_config, handle) is called
+     *         from the ISR with the finished transaction, `user` can be used
+     *         there to post a completion event.
+     * @param  handle        [SPI device handle]
+     * @param  regAddr       [Register address to read from / write to]
+     * @param  length        [Number of bytes to transfer]
+     * @param  data          [Buffer to read into / write from]
+     * @param  transaction   [Caller-owned transaction descriptor, filled in here]
+     * @param  user          [User pointer stored in the transaction]
+     * @param  ticks_to_wait [Ticks to wait for room in the queue / for a result]
+     * @return  - ESP_ERR_INVALID_ARG   if parameter is invalid
+     *          - ESP_ERR_INVALID_SIZE  if `length` is 0 (queue*Bytes)
+     *          - ESP_ERR_TIMEOUT       if nothing could be queued / completed in time
+     *          - ESP_OK                on success
+     */
+    esp_err_t queueReadBytes(spi_device_handle_t handle, uint8_t regAddr, size_t length, uint8_t *data,
+                             spi_transaction_t *transaction, void *user = NULL,
+                             TickType_t ticks_to_wait = portMAX_DELAY);
+    esp_err_t queueWriteBytes(spi_device_handle_t handle, uint8_t regAddr, size_t length, const uint8_t *data,
+                              spi_transaction_t *transaction, void *user = NULL,
+                              TickType_t ticks_to_wait = portMAX_DELAY);
+    esp_err_t getTransResult(spi_device_handle_t handle, spi_transaction_t **transaction,
+                             TickType_t ticks_to_wait = portMAX_DELAY);
 } SPI_t;
 
 
@@ -61,7 +61,7 @@ SPI::~SPI() {
     close();
 }
 
-esp_err_t SPI::begin(int mosi_io_num, int miso_io_num, int sclk_io_num, int max_transfer_sz) {
+esp_err_t SPI::begin(int mosi_io_num, int miso_io_num, int sclk_io_num, int max_transfer_sz, int dma_chan) {
     spi_bus_config_t config;
     memset(&config, 0, sizeof(spi_bus_config_t));
     config.mosi_io_num = mosi_io_num;
@@ -70,14 +70,15 @@ esp_err_t SPI::begin(int mosi_io_num, int miso_io_num, int sclk_io_num, int max_
     config.quadwp_io_num = -1;  // -1 not used
     config.quadhd_io_num = -1;  // -1 not used
     config.max_transfer_sz = max_transfer_sz;
-    return spi_bus_initialize(host, &config, 0);  // 0 DMA not used
+    return spi_bus_initialize(host, &config, dma_chan);  // 0 DMA not used
 }
 
 esp_err_t SPI::close() {
     return spi_bus_free(host);
 }
 
-esp_err_t SPI::addDevice(uint8_t mode, uint32_t clock_speed_hz, int cs_io_num, spi_device_handle_t *handle) {
+esp_err_t SPI::addDevice(uint8_t mode, uint32_t clock_speed_hz, int cs_io_num, spi_device_handle_t *handle,
+                         int queue_size) {
     spi_device_interface_config_t dev_config;
     memset(&dev_config, 0, sizeof(spi_device_interface_config_t));
     dev_config.command_bits = 0;
@@ -90,7 +91,7 @@ esp_err_t SPI::addDevice(uint8_t mode, uint32_t clock_speed_hz, int cs_io_num, s
     dev_config.clock_speed_hz = clock_speed_hz;
     dev_config.spics_io_num = cs_io_num;
     dev_config.flags = 0;  // 0 not used
-    dev_config.queue_size = 1;
+    dev_config.queue_size = queue_size;
     dev_config.pre_cb = NULL;
     dev_config.post_cb = NULL;
     return spi_bus_add_device(host, &dev_config, handle);
@@ -207,3 +208,37 @@ esp_err_t SPI::readBytes(spi_device_handle_t handle, uint8_t regAddr, size_t len
 }
 
 
+/*******************************************************************************
+ * QUEUED
+ ******************************************************************************/
+esp_err_t SPI::queueReadBytes(spi_device_handle_t handle, uint8_t regAddr, size_t length, uint8_t *data,
+                              spi_transaction_t *transaction, void *user, TickType_t ticks_to_wait) {
+    if(length == 0) return ESP_ERR_INVALID_SIZE;
+    memset(transaction, 0, sizeof(spi_transaction_t));
+    transaction->addr = regAddr | SPIBUS_READ;
+    transaction->length = length * 8;
+    transaction->rxlength = length * 8;
+    transaction->user = user;
+    transaction->rx_buffer = data;
+    esp_err_t err = spi_device_queue_trans(handle, transaction, ticks_to_wait);
+    ESP_LOGD(TAG, "Queued receiving %zu bytes -> %d", length, err);
+    return err;
+}
+
+esp_err_t SPI::queueWriteBytes(spi_device_handle_t handle, uint8_t regAddr, size_t length, const uint8_t *data,
+                               spi_transaction_t *transaction, void *user, TickType_t ticks_to_wait) {
+    if(length == 0) return ESP_ERR_INVALID_SIZE;
+    memset(transaction, 0, sizeof(spi_transaction_t));
+    transaction->addr = regAddr & SPIBUS_WRITE;
+    transaction->length = length * 8;
+    transaction->user = user;
+    transaction->tx_buffer = data;
+    esp_err_t err = spi_device_queue_trans(handle, transaction, ticks_to_wait);
+    ESP_LOGD(TAG, "Queued sending %zu bytes -> %d", length, err);
+    return err;
+}
+
+esp_err_t SPI::getTransResult(spi_device_handle_t handle, spi_transaction_t **transaction,
+                              TickType_t ticks_to_wait) {
+    return spi_device_get_trans_result(handle, transaction, ticks_to_wait);
+}
@@ -21,6 +21,7 @@
 #define BQ34Z100 0x55
 #define PAGE_SIZE 32
 #define TI_DEVICE_TYPE 0x100
+#define VOLTAGE_DIVIDER 19239
 
 /**
  * Module Singleton
@@ -66,6 +67,85 @@ const ModuleConfig &_ModuleFuelGauge::getModuleConfig() { return config; }
 
 static const TickType_t TIMER_FUEL_GAUGE_MEASURE_PERIOD = 10000 / portTICK_PERIOD_MS;
 
+/**
+ * Maximum number of measurement cycles to skip before probing an empty
+ * channel again (back-off doubles on every failed probe)
+ */
+static const uint8_t PROBE_BACKOFF_MAX = 16;
+
+/**
+ * Consecutive failed reads before a known gauge is considered unplugged
+ */
+static const uint8_t READ_FAILURES_MAX = 3;
+
+/**
+ * Select the I2C expander channel, unless it's already selected
+ *
+ * `setChannel` does not report failures, so the callers forget the selection
+ * (CHANNEL_UNKNOWN) on any I2C error, in case the expander was reset.
+ */
+void _ModuleFuelGauge::selectChannel(uint8_t channel)
+{
+	if (channel == selectedChannel) return;
+	ModuleI2CExpander.setChannel(channel);
+	selectedChannel = channel;
+}
+
+/**
+ * Configure the gauge on the selected channel for our pack
+ *
+ * The settings live in the gauge's data flash and survive unplugging, so
+ * they are only written (and the gauge reset) if they differ.
+ */
+esp_err_t _ModuleFuelGauge::configureDevice()
+{
+	bool changed = false;
+	esp_err_t err;
+
+	// Unseal the device
+	err = bq34z100g1_unseal(ModuleI2CExpander, 0x36720414);
+	if (err != ESP_OK) return err;
+
+	// Configure pack
+	bq34z100g1_pack_config cfg;
+	err = bq34z100g1_getPackConfig(ModuleI2CExpander, &cfg);
+	if (err != ESP_OK) return err;
+	if (cfg.voltsel != 1) {
+		cfg.voltsel = 1; // Use external voltage divider
+		err = bq34z100g1_setPackConfig(ModuleI2CExpander, &cfg);
+		if (err != ESP_OK) return err;
+		changed = true;
+	}
+
+	// Configure voltage divider
+	bq34z100g1_calib_data cd;
+	err = bq34z100g1_getCalibData(ModuleI2CExpander, &cd);
+	if (err != ESP_OK) return err;
+	if (cd.voltage_divider != VOLTAGE_DIVIDER) {
+		err = bq34z100g1_setVoltageDivider(ModuleI2CExpander, VOLTAGE_DIVIDER);
+		if (err != ESP_OK) return err;
+		cd.voltage_divider = VOLTAGE_DIVIDER;
+		changed = true;
+	}
+
+	if (changed) {
+		TRACE_LOGI(TAG, "Updated FuelGauge configuration, resetting");
+		err = bq34z100g1_reset(ModuleI2CExpander);
+		if (err != ESP_OK) return err;
+	}
+
+	TRACE_LOGD(TAG, "--[ Calibration Data ]--");
+	TRACE_LOGD(TAG, "        cc_gain = %.2f", cd.cc_gain);
+	TRACE_LOGD(TAG, "       cc_delta = %.2f", cd.cc_delta);
+	TRACE_LOGD(TAG, "      cc_offset = %d", cd.cc_offset);
+	TRACE_LOGD(TAG, "   board_offset = %d", cd.board_offset);
+	TRACE_LOGD(TAG, "int_temp_offset = %d", cd.int_temp_offset);
+	TRACE_LOGD(TAG, "ext_temp_offset = %d", cd.ext_temp_offset);
+	TRACE_LOGD(TAG, "voltage_divider = %d", cd.voltage_divider);
+
+	return ESP_OK;
+}
+
 /**
  * Event handler for network events
  */
@@ -90,8 +170,8 @@ DEFINE_EVENT_HANDLER(_ModuleFuelGauge::all_events)
 		TRACE_LOGD(TAG, "Sampling FuelGauge channels");
 		{
 			bool found = false;
-			uint16_t v_dt, v_cap, v_voltage, v_current, v_temp, v_soh;
-			uint8_t v_soc;
+			uint16_t v_dt;
+			bq34z100g1_standard_data sd;
 			esp_err_t err;
 
 			// Scan all channels for a FuelGauge sensor
@@ -104,77 +184,85 @@ DEFINE_EVENT_HANDLER(_ModuleFuelGauge::all_events)
 				// Device D (0) = 3
 				uint8_t id = 3 - i;
 
-				// Set I2C Expander Channel
-				ModuleI2CExpander.setChannel(1 + i);
-
-				// Try to read the device type
-				err = bq34z100g1_deviceType(ModuleI2CExpander, &v_dt);
-				if ((err == ESP_OK) && (v_dt == TI_DEVICE_TYPE)) {
-					found = true;
-
-					if (!devicePresent[id]) {
-						devicePresent[id] = true;
-
-						// Unseal the device
-						ESP_ERROR_OOPS(bq34z100g1_unseal(ModuleI2CExpander, 0x36720414));
-
-						// Configure pack
-						bq34z100g1_pack_config cfg;
-						ESP_ERROR_OOPS(bq34z100g1_getPackConfig(ModuleI2CExpander, &cfg));
-						cfg.voltsel = 1; // Use external voltage divider
-						ESP_ERROR_OOPS(bq34z100g1_setPackConfig(ModuleI2CExpander, &cfg));
+				// Empty channels are re-probed with an exponential back-off,
+				// so we are not waiting for I2C time-outs on every cycle
+				if (!devicePresent[id] && (probeCountdown[id] > 0)) {
+					probeCountdown[id]--;
+					continue;
+				}
 
-						// Configure voltage divider
-						// bq34z100g1_calib_data data;
-						ESP_ERROR_OOPS(bq34z100g1_setVoltageDivider(ModuleI2CExpander, 19239));
+				// Set I2C Expander Channel
+				selectChannel(1 + i);
+
+				if (!devicePresent[id]) {
+
+					// Try to read the device type
+					err = bq34z100g1_deviceType(ModuleI2CExpander, &v_dt);
+					if ((err != ESP_OK) || (v_dt != TI_DEVICE_TYPE)) {
+						if (err != ESP_OK) selectedChannel = CHANNEL_UNKNOWN;
+						probeBackoff[id] = probeBackoff[id] ? probeBackoff[id] * 2 : 1;
+						if (probeBackoff[id] > PROBE_BACKOFF_MAX) probeBackoff[id] = PROBE_BACKOFF_MAX;
+						probeCountdown[id] = probeBackoff[id];
+						continue;
+					}
 
-						ESP_ERROR_OOPS(bq34z100g1_reset(ModuleI2CExpander));
+					TRACE_LOGI(TAG, "FuelGauge sensor=%d plugged in", id);
+					devicePresent[id] = true;
+					probeBackoff[id] = 0;
+					readFailures[id] = 0;
+
+					err = configureDevice();
+					if (err != ESP_OK) {
+						TRACE_LOGE(TAG, "Could not configure FuelGauge sensor=%d, error=%#X", id, err);
+						selectedChannel = CHANNEL_UNKNOWN;
+						devicePresent[id] = false;
+						continue;
 					}
+				}
 
-					ESP_ERROR_OOPS(bq34z100g1_stateOfCharge(ModuleI2CExpander, &v_soc));
-					ESP_ERROR_OOPS(bq34z100g1_remainingCapacity(ModuleI2CExpander, &v_cap));
-					ESP_ERROR_OOPS(bq34z100g1_voltage(ModuleI2CExpander, &v_voltage));
-					ESP_ERROR_OOPS(bq34z100g1_averageCurrent(ModuleI2CExpander, &v_current));
-					ESP_ERROR_OOPS(bq34z100g1_temperature(ModuleI2CExpander, &v_temp));
-					ESP_ERROR_OOPS(bq34z100g1_stateOfHealth(ModuleI2CExpander, &v_soh));
-
-					TRACE_LOGI(TAG, "Found FuelGauge sensor=%d {SOC=%d, Capacity=%d, Volt=%d, Amp=%d, Temp=%d, SOH=%d}",
-						id, v_soc, v_cap, v_voltage, v_current, v_temp, v_soh
-					);
-
-					float v = (float)v_voltage / 1000;
-					float a = (float)v_current / 1000;
-					snprintf(deviceStatus[id], 32, "\xe2\x9c\x85 %d%% (%.2f V, %0.2f A)", v_soc, v, a);
-
-					bq34z100g1_calib_data cd;
-					bq34z100g1_getCalibData(ModuleI2CExpander, &cd);
-					TRACE_LOGD(TAG, "--[ Calibration Data ]--");
-					TRACE_LOGD(TAG, "        cc_gain = %.2f", cd.cc_gain);
-					TRACE_LOGD(TAG, "       cc_delta = %.2f", cd.cc_delta);
-					TRACE_LOGD(TAG, "      cc_offset = %d", cd.cc_offset);
-					TRACE_LOGD(TAG, "   board_offset = %d", cd.board_offset);
-					TRACE_LOGD(TAG, "int_temp_offset = %d", cd.int_temp_offset);
-					TRACE_LOGD(TAG, "ext_temp_offset = %d", cd.ext_temp_offset);
-					TRACE_LOGD(TAG, "voltage_divider = %d", cd.voltage_divider);
-
-					// If this is a request to get a measurement, send the computed
-					// values to SensorHub
-					if (event_id == EVENT_FUELGAUGE_GET_MEASUREMENT) {
-
-						// Add FuelGauge measurements as fuelgauge/X where X is the channel
-						auto g = sensor.group(id);
-						ModuleSensorHub.addMeasurement(g, {
-							{ "soc", v_soc },
-							{ "cap", v_cap },
-							{ "voltage", v_voltage },
-							{ "current", v_current },
-							{ "temp", v_temp },
-							{ "soh", v_soh },
-						});
+				// Read all the standard commands in one go. A gauge can be busy
+				// for a while (eg. after a reset), so only consider it unplugged
+				// after a few consecutive failures
+				err = bq34z100g1_standardData(ModuleI2CExpander, &sd);
+				if (err != ESP_OK) {
+					selectedChannel = CHANNEL_UNKNOWN;
+					if (++readFailures[id] < READ_FAILURES_MAX) {
+						TRACE_LOGW(TAG, "FuelGauge sensor=%d read failed (%d/%d), error=%#X",
+							id, readFailures[id], READ_FAILURES_MAX, err);
+						continue;
 					}
 
-				} else {
+					TRACE_LOGW(TAG, "FuelGauge sensor=%d removed, error=%#X", id, err);
+					devicePresent[id] = false;
+					probeCountdown[id] = 0;
 					snprintf(deviceStatus[id], 32, "\xe2\xac\x9c No Device");
+					continue;
+				}
+				readFailures[id] = 0;
+				found = true;
+
+				TRACE_LOGI(TAG, "Found FuelGauge sensor=%d {SOC=%d, Capacity=%d, Volt=%d, Amp=%d, Temp=%d, SOH=%d}",
+					id, sd.soc, sd.remaining_capacity, sd.voltage, sd.average_current, sd.temperature, sd.soh
+				);
+
+				float v = (float)sd.voltage / 1000;
+				float a = (float)sd.average_current / 1000;
+				snprintf(deviceStatus[id], 32, "\xe2\x9c\x85 %d%% (%.2f V, %0.2f A)", sd.soc, v, a);
+
+				// If this is a request to get a measurement, send the computed
+				// values to SensorHub
+				if (event_id == EVENT_FUELGAUGE_GET_MEASUREMENT) {
+
+					// Add FuelGauge measurements as fuelgauge/X where X is the channel
+					auto g = sensor.group(id);
+					ModuleSensorHub.addMeasurement(g, {
+						{ "soc", sd.soc },
+						{ "cap", sd.remaining_capacity },
+						{ "voltage", sd.voltage },
+						{ "current", sd.average_current },
+						{ "temp", sd.temperature },
+						{ "soh", sd.soh },
+					});
 				}
 			}
 
@@ -222,7 +310,11 @@ std::vector<ValueDefinition> _ModuleFuelGauge::configOptions()
  */
 void _ModuleFuelGauge::configDidSave()
 {
-	nvsSave();
+	// The options are all read-only status labels, don't wear the flash
+	// re-writing an unchanged blob on every UI save
+	if (configChanged) {
+		nvsSave();
+	}
 }
 
 /**
@@ -263,8 +355,14 @@ void _ModuleFuelGauge::activate()
 	eventPostAfter(EVENT_FUELGAUGE_TIMED_MEASUREMENT, NULL, 0, TIMER_FUEL_GAUGE_MEASURE_PERIOD);
 	eventPost(EVENT_FUELGAUGE_GET_MEASUREMENT, NULL, 0);
 
+	// We don't know what the expander is currently pointing to
+	selectedChannel = CHANNEL_UNKNOWN;
+
 	for (int i=0; i<4; ++i) {
 		devicePresent[i] = false;
+		probeBackoff[i] = 0;
+		probeCountdown[i] = 0;
+		readFailures[i] = 0;
 		memset(deviceStatus[i], 0, 32);
 		snprintf(deviceStatus[i], 32, "\xe2\xac\x9c No Device");
 	}
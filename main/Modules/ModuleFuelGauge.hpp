@@ -25,6 +25,8 @@
 #define SUBCLASS_ID_CAL_CURRENT           107
 #define SUBCLASS_ID_CODES                 112
 
+#define CHANNEL_UNKNOWN                   0xFF
+
 ////////////////////////////////////////////////////////////////////////////////////////
 enum ModuleFuelGaugeEvents {
   EVENT_FUELGAUGE_READY,
@@ -84,6 +86,33 @@ private:
   bool devicePresent[4];
   char deviceStatus[4][32];
 
+  /**
+   * Number of measurement cycles to wait before probing an empty channel
+   * again, and how many of them are still left
+   */
+  uint8_t probeBackoff[4];
+  uint8_t probeCountdown[4];
+
+  /**
+   * Consecutive failed reads of a known gauge
+   */
+  uint8_t readFailures[4];
+
+  /**
+   * The I2C expander channel last selected
+   */
+  uint8_t selectedChannel;
+
+  /**
+   * Select the I2C expander channel, unless it's already selected
+   */
+  void selectChannel(uint8_t channel);
+
+  /**
+   * Configure the gauge on the selected channel, if needed
+   */
+  esp_err_t configureDevice();
+
 };
 
 extern _ModuleFuelGauge ModuleFuelGauge;
@@ -1,3 +1,5 @@
+#include <cstddef>
+
 #include "ModuleGPS.hpp"
 #include "Modules/ModuleVBus.hpp"
 #include "Modules/ModuleSensorHub.hpp"
@@ -7,6 +9,8 @@
 #include "KudzuKernel.hpp"
 #include "Sherlock.hpp"
 #include "esp_log.h"
+#include "esp_attr.h"
+#include "rom/crc.h"
 
 /**
  * Instantiate singleton
@@ -15,7 +19,12 @@ _ModuleGPS ModuleGPS;
 
 #define POWER_RAMPDOWN_TIMEOUT 		15000 / portTICK_PERIOD_MS
 
-#define CHUNK_TRANSMISSION_SIZE 	64
+/**
+ * UART0 runs without a TX ring buffer, so `write` blocks the event loop until
+ * everything but the last FIFO load is on the wire. Never hand it more than
+ * one hardware FIFO worth of data and pace the next chunk on the drain.
+ */
+#define CHUNK_TRANSMISSION_SIZE 	UART_FIFO_LEN
 
 /**
  * The GPS sensor configuration
@@ -604,6 +613,29 @@ struct WriteChunkEvent {
 	int32_t 			evt;
 };
 
+/**
+ * State kept in RTC slow memory across deep sleep. When we wake up with the
+ * RTC memory preserved, the receiver is seeded with the last fix and the time
+ * for a hot start. The receiver is powered by VBus and loses its aiding data
+ * on every deactivation, so the AssistNow data are always uploaded again.
+ */
+#define GPS_RTC_MAGIC 						0x31535047	/* "GPS1" */
+#define GPS_RTC_VERSION 					2
+#define GPS_RTC_BUDGET 						48 					/* Bytes of RTC memory we may use */
+
+struct GPSRtcSnapshot {
+	uint32_t	magic;
+	uint16_t	version;
+	uint8_t		has_fix;
+	uint8_t		reserved;
+	float			lat, lng, alt;
+	int32_t		fix_time;
+	uint32_t	crc;
+};
+static_assert(sizeof(GPSRtcSnapshot) <= GPS_RTC_BUDGET, "GPS RTC snapshot exceeds its budget");
+
+static RTC_NOINIT_ATTR GPSRtcSnapshot rtcSnapshot;
+
 /**
  * Module configuration
  */
@@ -628,6 +660,16 @@ static const ModuleConfig config = {
 static const char *TAG = config.name;
 const ModuleConfig &_ModuleGPS::getModuleConfig() { return config; }
 
+/**
+ * Ticks needed by UART0 to shift out `len` bytes (8N1, 10 bits per byte)
+ */
+static TickType_t chunkDrainTicks(size_t len)
+{
+	uint32_t baud = ModuleUART0.uart_config.baud_rate;
+	if (baud == 0) return 1;
+	return (len * 10 * 1000 / baud) / portTICK_PERIOD_MS + 1;
+}
+
 ///////////////////////////////
 // Module life-cycle methods
 ///////////////////////////////
@@ -635,7 +677,7 @@ const ModuleConfig &_ModuleGPS::getModuleConfig() { return config; }
 _ModuleGPS::_ModuleGPS()
 	: Module(), WithFSM(), activeTimer(NULL), io_conf(), v_fix(false),
 	  v_siv_gps(0), v_siv_glonass(0), v_siv_galileo(0),
-	  fix_cog(0), fix_speed(0)
+	  fix_cog(0), fix_speed(0), fix_time(0)
 {
 	memset(v_sat_in_view, 0, 40);
 	snprintf(v_sat_in_view, 40, "GPS Off");
@@ -660,16 +702,38 @@ void _ModuleGPS::activate()
 	TRACE_LOGD(TAG, "Activating");
 	snprintf(v_sat_in_view, 40, "0 (0 GP, 0 GA, 0 GL)");
 
+	if (restoreSnapshot() && fix_time) {
+		// Waking up from deep sleep, help the receiver to a hot start
+		ubxSendTime();
+		ubxSendPosition();
+	}
+
+	applyAssistNow((const char*)AGPS, sizeof(AGPS));
+
+	// Immediately acknowledge the activation
+	ackActivate();
+}
+
+/**
+ * Upload AssistNOW offline geolocation data
+ *
+ * The payload is streamed to the receiver in FIFO-sized chunks from the event
+ * loop and must stay valid until EVENT_GPS_AGPS_DONE is posted.
+ */
+esp_err_t _ModuleGPS::applyAssistNow(const char * payload, const size_t len)
+{
+	if ((payload == NULL) || (len == 0)) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
 	WriteChunkEvent ev = {
-		.ptr = (const char*)AGPS,
+		.ptr = payload,
 		.ofs = 0,
-		.len = sizeof(AGPS),
+		.len = len,
 		.evt = EVENT_GPS_AGPS_DONE,
 	};
 	eventPost(EVENT_GPS_WRITE_CHUNK, &ev, sizeof(ev));
-
-	// Immediately acknowledge the activation
-	ackActivate();
+	return ESP_OK;
 }
 
 /**
@@ -682,6 +746,61 @@ void _ModuleGPS::deactivate()
 	ackDeactivate();
 }
 
+/**
+ * Keep the last fix in RTC memory before going to deep sleep
+ */
+void _ModuleGPS::shutdown()
+{
+	saveSnapshot();
+}
+
+/**
+ * Save the last fix in RTC memory
+ */
+void _ModuleGPS::saveSnapshot()
+{
+	GPSRtcSnapshot snap;
+	memset(&snap, 0, sizeof(snap));
+
+	snap.magic = GPS_RTC_MAGIC;
+	snap.version = GPS_RTC_VERSION;
+	snap.has_fix = fix_time != 0;
+	snap.lat = fix_lat;
+	snap.lng = fix_lng;
+	snap.alt = fix_alt;
+	snap.fix_time = fix_time;
+	snap.crc = crc32_le(0, (const uint8_t*)&snap, offsetof(GPSRtcSnapshot, crc));
+
+	rtcSnapshot = snap;
+	TRACE_LOGD(TAG, "Saved RTC snapshot {fix=%d}", snap.has_fix);
+}
+
+/**
+ * Restore the last fix from RTC memory
+ */
+bool _ModuleGPS::restoreSnapshot()
+{
+	GPSRtcSnapshot snap = rtcSnapshot;
+
+	// The RTC memory is garbage after a power-on or a reset
+	if (!Kernel.isRTCMemPerserved()) return false;
+	if ((snap.magic != GPS_RTC_MAGIC) || (snap.version != GPS_RTC_VERSION)) return false;
+	if (snap.crc != crc32_le(0, (const uint8_t*)&snap, offsetof(GPSRtcSnapshot, crc))) {
+		TRACE_LOGW(TAG, "Corrupted RTC snapshot");
+		return false;
+	}
+
+	if (snap.has_fix) {
+		fix_lat = snap.lat;
+		fix_lng = snap.lng;
+		fix_alt = snap.alt;
+		fix_time = snap.fix_time;
+	}
+
+	TRACE_LOGI(TAG, "Restored RTC snapshot {fix=%d}", snap.has_fix);
+	return true;
+}
+
 ///////////////////////////////
 // User interface binding
 ///////////////////////////////
@@ -787,6 +906,37 @@ int _ModuleGPS::ubxWrite(uint8_t msgClass, uint8_t msgId, const uint8_t * data,
   return sizeof(hdr) + sizeof(csum) + len;
 }
 
+/**
+ * Send the last known position to the receiver as an aiding hint
+ * (UBX-MGA-INI-POS_LLH)
+ */
+void _ModuleGPS::ubxSendPosition()
+{
+	uint8_t pos_info[20];
+	int32_t v32;
+	int ret;
+
+	memset(pos_info, 0, sizeof(pos_info));
+	pos_info[0] = 0x01; // Message type
+	pos_info[1] = 0x00; // Version
+
+	v32 = (int32_t)(fix_lat * 1e7);
+	memcpy(&pos_info[4], &v32, 4); 		// Latitude (1e-7 deg)
+	v32 = (int32_t)(fix_lng * 1e7);
+	memcpy(&pos_info[8], &v32, 4); 		// Longitude (1e-7 deg)
+	v32 = (int32_t)(fix_alt * 100);
+	memcpy(&pos_info[12], &v32, 4); 	// Altitude (cm)
+	v32 = 100000; // The boat could have drifted, give it 1km tolerance
+	memcpy(&pos_info[16], &v32, 4); 	// Position accuracy (cm)
+
+	ret = ubxWrite(0x13, 0x40, pos_info, sizeof(pos_info));
+	if (ret < 0) {
+		TRACE_LOGE(TAG, "Could not send last position: error=%d", ret);
+	} else {
+		TRACE_LOGI(TAG, "Pushed last known position to GPS module");
+	}
+}
+
 void _ModuleGPS::ubxSendTime()
 {
 	uint8_t time_info[24];
@@ -878,6 +1028,7 @@ DEFINE_EVENT_HANDLER(_ModuleGPS::nmea_events)(esp_event_base_t event_base, int32
 			fix_lat = msg->latitude;
 			fix_lng = msg->longitude;
 			fix_alt = msg->altitude;
+			fix_time = time(NULL);
 		}
 		break;
 	case EVENT_NMEA_STATEMENT_GSA:
@@ -960,6 +1111,17 @@ DEFINE_EVENT_HANDLER(_ModuleGPS::gps_events)(esp_event_base_t event_base, int32_
   switch (event_id) {
   case EVENT_GPS_WRITE_CHUNK:
   	memcpy(&ev, event_data, sizeof(ev));
+
+  	// The previous chunk is still in the FIFO, come back once it drained
+  	// instead of blocking the event loop inside the driver. With no timer
+  	// left, write anyway and let the driver wait for room in the FIFO.
+  	if (uart_wait_tx_done(ModuleUART0.uart_port, 0) == ESP_ERR_TIMEOUT) {
+  		if (eventPostAfter(EVENT_GPS_WRITE_CHUNK, &ev, sizeof(ev), 1) != NULL) {
+  			return;
+  		}
+  		TRACE_LOGW(TAG, "No timer left to wait for the FIFO, writing anyway");
+  	}
+
   	len = ev.len - ev.ofs;
   	if (len > CHUNK_TRANSMISSION_SIZE) {
   		len = CHUNK_TRANSMISSION_SIZE;
@@ -974,7 +1136,10 @@ DEFINE_EVENT_HANDLER(_ModuleGPS::gps_events)(esp_event_base_t event_base, int32_
 
   	ev.ofs += len;
   	if (ev.ofs < ev.len) {
-			eventPost(EVENT_GPS_WRITE_CHUNK, &ev, sizeof(ev));
+			if (eventPostAfter(EVENT_GPS_WRITE_CHUNK, &ev, sizeof(ev), chunkDrainTicks(len)) == NULL) {
+				TRACE_LOGW(TAG, "No timer left for the next chunk, posting it now");
+				eventPost(EVENT_GPS_WRITE_CHUNK, &ev, sizeof(ev));
+			}
   	} else {
   		eventPost(ev.evt, NULL, 0);
   	}
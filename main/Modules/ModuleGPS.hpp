@@ -116,6 +116,11 @@ protected:
    */
   virtual void deactivate();
 
+  /**
+   * Keep the last fix in RTC memory before going to deep sleep
+   */
+  virtual void shutdown();
+
 private:
 
   /**
@@ -125,6 +130,17 @@ private:
 
   void ubxSendTime();
 
+  /**
+   * Send the last known position to the receiver as an aiding hint
+   */
+  void ubxSendPosition();
+
+  /**
+   * Save to, or restore from the RTC memory snapshot
+   */
+  void saveSnapshot();
+  bool restoreSnapshot();
+
 private:
 
   /**
@@ -148,6 +164,7 @@ private:
    * Last known location
    */
   float           fix_lat, fix_lng, fix_alt, fix_cog, fix_speed;
+  time_t          fix_time;
 
   /**
    * The last GPS measurement
@@ -7,6 +7,8 @@
 #include "Pinout.hpp"
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_sleep.h"
+#include "driver/gpio.h"
 
 #include "mpu/math.hpp"
 #include "mpu/types.hpp"
@@ -30,10 +32,47 @@ static SensorConfig sensor("imu");
  * NVS configuration
  */
 struct IMUNvsConfig {
-  int sensitivity;
+  int motion_threshold;   // mg, 0 samples continuously
 };
 
-static constexpr uint32_t MPU_SPI_CLOCK_SPEED = 10000;  // up to 1MHz for all registers, and 20MHz for sensor data registers only
+static constexpr uint32_t MPU_SPI_CLOCK_SPEED = 1000000;  // up to 1MHz for all registers, and 20MHz for sensor data registers only
+
+/**
+ * DMA channel for VSPI, needed for FIFO bursts longer than 64 bytes
+ */
+static constexpr int MPU_SPI_DMA_CHANNEL = 2;
+
+/**
+ * FIFO acquisition: the MPU samples on its own at FIFO_SAMPLE_RATE and we
+ * only wake up every FIFO_DRAIN_INTERVAL to empty it. At 50Hz with 12-byte
+ * packets the 1kB FIFO fills in ~1.7s, so draining every second leaves margin.
+ */
+static constexpr uint16_t FIFO_SAMPLE_RATE = 50;
+static constexpr size_t FIFO_PACKET_SIZE = IMU_FIFO_PACKET_SIZE;   // big-endian
+static_assert(IMU_FIFO_BURST_SIZE % FIFO_PACKET_SIZE == 0, "FIFO bursts must hold whole packets");
+static constexpr size_t FIFO_CAPACITY = 1024;    // See MPU::initialize()
+static const TickType_t FIFO_DRAIN_INTERVAL = 1000 / portTICK_PERIOD_MS;
+
+/**
+ * Orientation filter gain
+ */
+static constexpr float AHRS_BETA = 0.1f;
+
+/**
+ * Wake-on-motion, on boards where the IMU INT line is wired to an RTC-capable
+ * pin (PIN_INT_IMU, see CONFIG_IMU_INT_WAKEUP). While idle the MPU cycles its
+ * accelerometer at WAKE_ACCEL_RATE and raises INT when any axis changes by
+ * more than the configured threshold. We then sample at full rate until no
+ * motion was reported for MOTION_EPISODE.
+ */
+#if defined CONFIG_MPU6500
+static constexpr int MOTION_THRESHOLD_LSB = 4;    // mg
+static constexpr mpud::lp_accel_rate_t WAKE_ACCEL_RATE = mpud::LP_ACCEL_RATE_7_81HZ;
+#else
+static constexpr int MOTION_THRESHOLD_LSB = 32;   // mg
+static constexpr mpud::lp_accel_rate_t WAKE_ACCEL_RATE = mpud::LP_ACCEL_RATE_5HZ;
+#endif
+static const TickType_t MOTION_EPISODE = 30000 / portTICK_PERIOD_MS;
 
 /**
  * Module configuration
@@ -43,7 +82,7 @@ static const ModuleConfig config = {
   .title = "IMU Driver",
   .category = MODULE_CATEGORY_SENSOR,
   .nv_size = sizeof(IMUNvsConfig),
-  .nv_version = 1,
+  .nv_version = 2,
   .runlevels = {
     RUNLEVEL_EXT_POWER,
     RUNLEVEL_BAT_POWER
@@ -59,19 +98,167 @@ static const char * TAG = config.name;
 const ModuleConfig& _ModuleIMU::getModuleConfig() { return config; }
 
 _ModuleIMU::_ModuleIMU()
-  : Module(), mpu_spi_handle(), MPU()
+  : Module(), mpu_spi_handle(), MPU(), fifoAccum(), fifoSamples(0), fifoTrans(), fifoPending(false),
+    ahrs(AHRS_BETA), heading(0),
+    motionWake(false), mpuConnected(false), motionArmed(false), motionTimer(NULL), drainTimer(NULL)
 { }
 
+/**
+ * Configure the sample rate and route accel+gyro samples to the FIFO
+ */
+esp_err_t _ModuleIMU::startFIFO() {
+  esp_err_t err;
+  if ((err = MPU.setSampleRate(FIFO_SAMPLE_RATE))) return err;
+  if ((err = MPU.setFIFOConfig(mpud::FIFO_CFG_ACCEL | mpud::FIFO_CFG_GYRO))) return err;
+  if ((err = MPU.setFIFOEnabled(true))) return err;
+  if ((err = MPU.resetFIFO())) return err;
+
+  memset(fifoAccum, 0, sizeof(fifoAccum));
+  fifoSamples = 0;
+  ahrs.reset();
+  return ESP_OK;
+}
+
+/**
+ * Read everything in the FIFO in bursts and accumulate it
+ */
+esp_err_t _ModuleIMU::drainFIFO() {
+  spi_transaction_t *done;
+  esp_err_t err;
+
+  // A burst left in flight by a failed drain must be collected first, or its
+  // result would be returned in place of the next transaction on the device
+  if (fifoPending) {
+    if ((err = vspi.getTransResult(mpu_spi_handle, &done))) return err;
+    fifoPending = false;
+  }
+
+  // Reading the status also clears the overflow flag
+  mpud::int_stat_t status = MPU.getInterruptStatus();
+  if ((err = MPU.lastError())) return err;
+  uint16_t count = MPU.getFIFOCount();
+  if ((err = MPU.lastError())) return err;
+
+  // After an overflow the oldest packet was partially overwritten and the
+  // stream is no longer aligned, drop everything and start over
+  if ((status & mpud::INT_STAT_FIFO_OVERFLOW) || (count >= FIFO_CAPACITY)) {
+    TRACE_LOGW(TAG, "FIFO overflow, dropping %d bytes", count);
+    return MPU.resetFIFO();
+  }
+
+  // Leave incomplete packets in the FIFO for the next drain
+  count -= count % FIFO_PACKET_SIZE;
+  if (count == 0) return ESP_OK;
+
+  // Double-buffered: the next burst is transferred by DMA while the
+  // previous one is being summed up
+  size_t len = count > IMU_FIFO_BURST_SIZE ? IMU_FIFO_BURST_SIZE : count;
+  int cur = 0;
+
+  err = vspi.queueReadBytes(mpu_spi_handle, mpud::regs::FIFO_R_W, len, fifoBuffer[cur], &fifoTrans);
+  if (err) return err;
+  fifoPending = true;
+
+  while (count > 0) {
+    err = vspi.getTransResult(mpu_spi_handle, &done);
+    if (err) return err;
+    fifoPending = false;
+    count -= len;
+
+    size_t ready = len;
+    uint8_t *data = fifoBuffer[cur];
+    if (count > 0) {
+      len = count > IMU_FIFO_BURST_SIZE ? IMU_FIFO_BURST_SIZE : count;
+      cur ^= 1;
+      err = vspi.queueReadBytes(mpu_spi_handle, mpud::regs::FIFO_R_W, len, fifoBuffer[cur], &fifoTrans);
+      if (err) return err;
+      fifoPending = true;
+    }
+
+    int32_t sums[6] = {0, 0, 0, 0, 0, 0};
+    size_t packets = ready / FIFO_PACKET_SIZE;
+    mpud::sumAxesBatch(&data[0], FIFO_PACKET_SIZE, packets, &sums[0]);
+    mpud::sumAxesBatch(&data[6], FIFO_PACKET_SIZE, packets, &sums[3]);
+    for (int i = 0; i < 6; i++) {
+      fifoAccum[i] += sums[i];
+    }
+    fifoSamples += packets;
+
+    // Run the orientation filter at the sensor rate
+    mpud::raw_axes_t noBias;
+    mpud::accelGravityBatch(&data[0], FIFO_PACKET_SIZE, packets, noBias, mpud::ACCEL_FS_4G, burstAccel);
+    mpud::gyroRadPerSecBatch(&data[6], FIFO_PACKET_SIZE, packets, noBias, mpud::GYRO_FS_500DPS, burstGyro);
+    for (size_t i = 0; i < packets; i++) {
+      ahrs.update(burstGyro[i].x, burstGyro[i].y, burstGyro[i].z,
+                  burstAccel[i].x, burstAccel[i].y, burstAccel[i].z, 1.0f / FIFO_SAMPLE_RATE);
+    }
+  }
+
+  return ESP_OK;
+}
+
+/**
+ * Stop sampling and leave the MPU in low-power accel mode, raising the
+ * interrupt pin when the motion threshold is crossed
+ */
+esp_err_t _ModuleIMU::armWakeOnMotion() {
+  IMUNvsConfig * conf = (IMUNvsConfig*)nvs();
+  esp_err_t err;
+
+  int threshold = conf->motion_threshold / MOTION_THRESHOLD_LSB;
+  mpud::mot_config_t motion{};
+  motion.threshold = threshold < 1 ? 1 : (threshold > 255 ? 255 : threshold);
+
+  if ((err = MPU.setFIFOEnabled(false))) return err;
+  if ((err = MPU.setLowPowerAccelRate(WAKE_ACCEL_RATE))) return err;
+  if ((err = MPU.setMotionDetectConfig(motion))) return err;
+  if ((err = MPU.setMotionFeatureEnabled(true))) return err;
+  if ((err = MPU.setInterruptEnabled(mpud::INT_EN_MOTION_DETECT))) return err;
+  if ((err = MPU.setLowPowerAccelMode(true))) return err;
+
+  // Release a motion latched while we were still sampling
+  MPU.getInterruptStatus();
+  if ((err = MPU.lastError())) return err;
+
+  motionArmed = true;
+  return ESP_OK;
+}
+
+/**
+ * Leave low-power mode and sample through the FIFO at full rate
+ */
+esp_err_t _ModuleIMU::startSampling() {
+  esp_err_t err;
+  if ((err = MPU.setInterruptEnabled(0))) return err;
+  if ((err = MPU.setLowPowerAccelMode(false))) return err;
+  if ((err = MPU.setMotionFeatureEnabled(false))) return err;
+  if ((err = startFIFO())) return err;
+
+  motionArmed = false;
+  return ESP_OK;
+}
+
+/**
+ * Motion interrupt pin handler
+ */
+void IRAM_ATTR _ModuleIMU::motionISR(void *arg) {
+  Modules.eventPostFromISRTo(&ModuleIMU, EVENT_IMU_MOTION, NULL, 0);
+}
+
 /**
  * Event handler for network events
  */
 DEFINE_EVENT_HANDLER(_ModuleIMU::all_events)(esp_event_base_t event_base, int32_t event_id, void *event_data) {
   TRACE_LOGD(TAG, "event='%s', id='%d'", event_base, event_id);
   esp_err_t err;
-  mpud::raw_axes_t accelRaw;   // x, y, z axes as int16
-  mpud::raw_axes_t gyroRaw;    // x, y, z axes as int16
+  float accelRes = mpud::accelResolution(mpud::ACCEL_FS_4G);
+  float gyroRes = mpud::gyroResolution(mpud::GYRO_FS_500DPS);
   mpud::float_axes_t accelG;   // accel axes in (g) gravity format
   mpud::float_axes_t gyroDPS;  // gyro axes in (DPS) º/s format
+  mpud::raw_axes_t accelRaw;
+#ifdef CONFIG_MPU_AK89xx
+  mpud::raw_axes_t magRaw;
+#endif
 
   switch (event_id) {
   case EVENT_IMU_CHECK_STARTUP:
@@ -95,9 +282,80 @@ DEFINE_EVENT_HANDLER(_ModuleIMU::all_events)(esp_event_base_t event_base, int32_
     }
 
     eventTimerStopAll();
+    motionTimer = NULL;
+    drainTimer = NULL;
+
+    if (motionWake) {
+      // Latch INT until the status register is read, so that the edge is
+      // still there when the chip wakes up from deep sleep
+      err = MPU.setInterruptConfig({ mpud::INT_LVL_ACTIVE_HIGH, mpud::INT_DRV_PUSHPULL,
+                                     mpud::INT_MODE_LATCH, mpud::INT_CLEAR_STATUS_REG });
+      if (!err) err = armWakeOnMotion();
+    } else {
+      err = startSampling();
+    }
+    if (err) {
+      TRACE_LOGE(TAG, "Failed to start the MPU sampling, error=%#X", err);
+      eventPostAfter(EVENT_IMU_RETRY_CONNECTION, NULL, 0, RETRY_INTERVAL);
+      break;
+    }
+
+    if (!motionArmed) {
+      drainTimer = eventPostAfter(EVENT_IMU_FIFO_DRAIN, NULL, 0, FIFO_DRAIN_INTERVAL);
+    } else if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_EXT0) {
+      // We were woken up by motion, start sampling right away
+      eventPost(EVENT_IMU_MOTION, NULL, 0);
+    }
+    mpuConnected = true;
     TRACE_LOGI(TAG, "MPU connected");
     break;
 
+  case EVENT_IMU_FIFO_DRAIN:
+    drainTimer = NULL;
+    if (motionArmed) break;
+    err = drainFIFO();
+    if (err) {
+      TRACE_LOGE(TAG, "Failed to drain the MPU FIFO, error=%#X", err);
+    }
+    drainTimer = eventPostAfter(EVENT_IMU_FIFO_DRAIN, NULL, 0, FIFO_DRAIN_INTERVAL);
+    break;
+
+  case EVENT_IMU_MOTION:
+    // Reading the status releases the latched INT line
+    MPU.getInterruptStatus();
+    if (motionArmed) {
+      TRACE_LOGI(TAG, "Motion detected, sampling at %d Hz", FIFO_SAMPLE_RATE);
+      err = startSampling();
+      if (err) {
+        TRACE_LOGE(TAG, "Failed to start the MPU sampling, error=%#X", err);
+        break;
+      }
+      drainTimer = eventPostAfter(EVENT_IMU_FIFO_DRAIN, NULL, 0, FIFO_DRAIN_INTERVAL);
+    }
+    if (motionTimer) eventTimerStop(motionTimer);
+    motionTimer = eventPostAfter(EVENT_IMU_MOTION_TIMEOUT, NULL, 0, MOTION_EPISODE);
+    break;
+
+  case EVENT_IMU_MOTION_TIMEOUT:
+    // End of the episode. If we are still moving the interrupt fires again
+    // right after arming and a new episode starts.
+    motionTimer = NULL;
+    if (drainTimer) eventTimerStop(drainTimer);
+    drainTimer = NULL;
+
+    // Keep what is in the FIFO for the next readout
+    err = drainFIFO();
+    if (err) {
+      TRACE_LOGE(TAG, "Failed to drain the MPU FIFO, error=%#X", err);
+    }
+    err = armWakeOnMotion();
+    if (err) {
+      TRACE_LOGE(TAG, "Failed to arm wake-on-motion, error=%#X", err);
+      break;
+    }
+    TRACE_LOGI(TAG, "No motion, waiting for wake-on-motion");
+    break;
+
   case EVENT_IMU_RETRY_CONNECTION:
     TRACE_LOGD(TAG, "Checking IMU connection");
 
@@ -115,17 +373,61 @@ DEFINE_EVENT_HANDLER(_ModuleIMU::all_events)(esp_event_base_t event_base, int32_
     break;
 
   case EVENT_IMU_READOUT:
-    // Read
-    MPU.acceleration(&accelRaw);  // fetch raw data from the registers
-    MPU.rotation(&gyroRaw);       // fetch raw data from the registers
-    // MPU.motion(&accelRaw, &gyroRaw);  // read both in one shot
-    // Convert
-    accelG = mpud::accelGravity(accelRaw, mpud::ACCEL_FS_4G);
-    gyroDPS = mpud::gyroDegPerSec(gyroRaw, mpud::GYRO_FS_500DPS);
+    // Collect whatever arrived since the last drain
+    if (!motionArmed) {
+      err = drainFIFO();
+      if (err) {
+        TRACE_LOGE(TAG, "Failed to drain the MPU FIFO, error=%#X", err);
+      }
+    } else if ((fifoSamples == 0) && (MPU.acceleration(&accelRaw) == ESP_OK)) {
+      // Idling in wake-on-motion: a single accel sample is enough for the
+      // attitude of a boat that is not moving
+      fifoAccum[0] = accelRaw.x;
+      fifoAccum[1] = accelRaw.y;
+      fifoAccum[2] = accelRaw.z;
+      fifoSamples = 1;
+      accelG = mpud::accelGravity(accelRaw, mpud::ACCEL_FS_4G);
+      ahrs.reset();
+      ahrs.update(0, 0, 0, accelG.x, accelG.y, accelG.z, 1.0f / FIFO_SAMPLE_RATE);
+    }
+    if (fifoSamples == 0) {
+      TRACE_LOGW(TAG, "No IMU samples collected");
+      break;
+    }
+
+    // Publish the average over all samples since the last measurement
+    accelG.x = accelRes * fifoAccum[0] / fifoSamples;
+    accelG.y = accelRes * fifoAccum[1] / fifoSamples;
+    accelG.z = accelRes * fifoAccum[2] / fifoSamples;
+    gyroDPS.x = gyroRes * fifoAccum[3] / fifoSamples;
+    gyroDPS.y = gyroRes * fifoAccum[4] / fifoSamples;
+    gyroDPS.z = gyroRes * fifoAccum[5] / fifoSamples;
     // Debug
+    TRACE_LOGI(TAG, "%d samples", fifoSamples);
     TRACE_LOGI(TAG, "accel: [%+6.2f %+6.2f %+6.2f ] (G) \t", accelG.x, accelG.y, accelG.z);
     TRACE_LOGI(TAG, "gyro: [%+7.2f %+7.2f %+7.2f ] (º/s)\n", gyroDPS[0], gyroDPS[1], gyroDPS[2]);
 
+    memset(fifoAccum, 0, sizeof(fifoAccum));
+    fifoSamples = 0;
+
+    // Absolute heading from the compass when available (AK89xx axes are
+    // X/Y swapped and Z inverted relative to the accelerometer). In
+    // wake-on-motion the aux I2C master is off, so the compass registers
+    // are stale and the AHRS only saw one accel sample: keep the last
+    // heading computed at full rate instead.
+    if (!motionArmed) {
+#ifdef CONFIG_MPU_AK89xx
+      if (MPU.heading(&magRaw) == ESP_OK) {
+        heading = ahrs.heading(magRaw.y, magRaw.x, -magRaw.z);
+      } else {
+        heading = ahrs.yaw();
+      }
+#else
+      heading = ahrs.yaw();
+#endif
+    }
+    TRACE_LOGI(TAG, "heel: %+6.1f pitch: %+6.1f heading: %5.1f", ahrs.heel(), ahrs.pitch(), heading);
+
     ModuleSensorHub.addMeasurement(sensor, {
       { "ax",  accelG.x },
       { "ay",  accelG.y },
@@ -133,6 +435,9 @@ DEFINE_EVENT_HANDLER(_ModuleIMU::all_events)(esp_event_base_t event_base, int32_
       { "gx",  gyroDPS[0] },
       { "gy",  gyroDPS[1] },
       { "gz",  gyroDPS[2] },
+      { "heel",  ahrs.heel() },
+      { "pitch", ahrs.pitch() },
+      { "hdg",   heading },
     });
     break;
   }
@@ -162,15 +467,37 @@ void _ModuleIMU::setup() {
  * Module activation and de-activation functions
  */
 void _ModuleIMU::activate() {
-  // IMUNvsConfig * conf = (IMUNvsConfig*)this->nvs();
+  IMUNvsConfig * conf = (IMUNvsConfig*)this->nvs();
 
   // Initialize SPI on HSPI host through SPIbus interface:
-  vspi.begin(PIN_E_MOSI, PIN_E_MISO, PIN_E_SCK);
+  vspi.begin(PIN_E_MOSI, PIN_E_MISO, PIN_E_SCK, SPI_MAX_DMA_LEN, MPU_SPI_DMA_CHANNEL);
   vspi.addDevice(0, MPU_SPI_CLOCK_SPEED, PIN_EN_IMU, &mpu_spi_handle);
 
   MPU.setBus(vspi);  // set bus port
   MPU.setAddr(mpu_spi_handle);  // set spi_device_handle, always needed!
 
+  mpuConnected = false;
+  motionArmed = false;
+
+  // Listen for the motion interrupt
+#ifdef PIN_INT_IMU
+  motionWake = conf->motion_threshold > 0;
+  if (motionWake) {
+    gpio_config_t io_conf = {};
+    io_conf.pin_bit_mask = 1ULL << PIN_INT_IMU;
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.intr_type = GPIO_INTR_POSEDGE;
+    gpio_config(&io_conf);
+
+    // (The ISR service might already be installed by someone else)
+    gpio_install_isr_service(0);
+    gpio_isr_handler_add(PIN_INT_IMU, motionISR, NULL);
+  }
+#else
+  motionWake = false;
+  (void)conf;
+#endif
+
   // Perform the start-up checkup
   eventPost(EVENT_IMU_CHECK_STARTUP, NULL, 0);
   ackActivate();
@@ -182,13 +509,100 @@ void _ModuleIMU::deactivate() {
   // Make sure there are no lingering timers that could bring the module
   // into an invalid state when they fire!
   eventTimerStopAll();
+  motionTimer = NULL;
+  drainTimer = NULL;
 
-  // Put chip to sleep
-  MPU.setSleep(true);
+  if (motionWake) {
+#ifdef PIN_INT_IMU
+    gpio_isr_handler_remove(PIN_INT_IMU);
+#endif
+
+    // Keep the MPU watching for motion, so that shutdown() can use it as a
+    // deep-sleep wake-up source (modules are de-activated before that)
+    if (mpuConnected && !motionArmed) armWakeOnMotion();
+  } else {
+    // Disarm the motion interrupt and put chip to sleep
+    MPU.setInterruptEnabled(0);
+    MPU.setSleep(true);
+    motionArmed = false;
+  }
+  mpuConnected = false;
+
+  // The device can't be removed with a transfer in flight
+  if (fifoPending) {
+    spi_transaction_t *done;
+    vspi.getTransResult(mpu_spi_handle, &done);
+    fifoPending = false;
+  }
 
   vspi.removeDevice(mpu_spi_handle);
   vspi.close();
+  mpu_spi_handle = NULL;
 
   ackDeactivate();
 }
 
+/**
+ * Called before going to deep sleep
+ */
+void _ModuleIMU::shutdown() {
+#ifdef PIN_INT_IMU
+  IMUNvsConfig * conf = (IMUNvsConfig*)this->nvs();
+  if (conf->motion_threshold <= 0) return;
+
+  // Still active (no SPI bus after deactivate), stop the motion episode
+  if (!motionArmed && mpu_spi_handle) armWakeOnMotion();
+
+  // The MPU is only armed if it was connected when we last talked to it
+  if (!motionArmed) {
+    TRACE_LOGW(TAG, "Wake-on-motion is not armed");
+    return;
+  }
+
+  TRACE_LOGI(TAG, "Waking up on motion");
+  esp_sleep_enable_ext0_wakeup(PIN_INT_IMU, 1);
+#endif
+}
+
+///////////////////////////////
+// User interface binding
+///////////////////////////////
+
+/**
+ * Return the UI configuration options
+ */
+std::vector<ValueDefinition> _ModuleIMU::configOptions() {
+#ifdef PIN_INT_IMU
+  IMUNvsConfig * conf = (IMUNvsConfig*)nvs();
+
+  return {
+    { "Motion Threshold",   BIND_INT(conf->motion_threshold),   WIDGET_NUMBER(),
+      "Acceleration change (in mg) that wakes up the IMU from low-power mode. Use 0 to sample continuously." }
+  };
+#else
+  return {};
+#endif
+}
+
+/**
+ * Handle the user clicking "save" on the UI
+ */
+void _ModuleIMU::configDidSave() {
+  if (configChanged) {
+    configChanged = false;
+    nvsSave();
+
+    // Restart
+    Modules.restart(this)->andIgnore();
+  }
+}
+
+/**
+ * Provide defaults to the persistent configuration
+ */
+void _ModuleIMU::nvsReset(void* nvs) {
+  IMUNvsConfig * conf = (IMUNvsConfig*)nvs;
+
+  conf->motion_threshold = 0;
+}
+
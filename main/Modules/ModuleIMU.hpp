@@ -1,8 +1,10 @@
 #ifndef KUDZUKERNEL_ModuleIMU_H
 #define KUDZUKERNEL_ModuleIMU_H
 #include <Module.hpp>
+#include "esp_attr.h"
 #include "SPIbus.hpp"
 #include "MPU.hpp"
+#include "Utilities/MadgwickAHRS.hpp"
 
 /**
  * Forward declaration of the module singleton
@@ -22,8 +24,22 @@ enum ModuleIMUEvents {
   EVENT_IMU_RETRY_CONNECTION,
   EVENT_IMU_INITIALIZE,
   EVENT_IMU_READOUT,
+  EVENT_IMU_FIFO_DRAIN,
+  EVENT_IMU_MOTION,
+  EVENT_IMU_MOTION_TIMEOUT,
 };
 
+/**
+ * Bytes of one accel (6) + gyro (6) sample in the MPU FIFO
+ */
+#define IMU_FIFO_PACKET_SIZE  12
+
+/**
+ * Bytes read from the MPU FIFO in one (DMA) SPI transaction. This is a
+ * multiple of the FIFO packet and of the 4-byte DMA word
+ */
+#define IMU_FIFO_BURST_SIZE   240
+
 ///////////////////////////////////////////
 // Declaration of the module
 ///////////////////////////////////////////
@@ -74,11 +90,105 @@ protected:
    */
   virtual void deactivate();
 
+  /**
+   * Arm the MPU motion interrupt as a deep-sleep wake-up source
+   */
+  virtual void shutdown();
+
+  ///////////////////////////////
+  // User interface binding
+  ///////////////////////////////
+
+  /**
+   * Return the UI configuration options
+   */
+  virtual std::vector<ValueDefinition> configOptions();
+
+  /**
+   * Handle the user clicking "save" on the UI
+   */
+  virtual void configDidSave();
+
+  /**
+   * Provide defaults to the persistent configuration
+   */
+  virtual void nvsReset(void *nvs);
 
 private:
   spi_device_handle_t   mpu_spi_handle;
   MPU_t                 MPU;
 
+  /**
+   * Running sums of the raw accel/gyro axes drained from the FIFO since
+   * the last published measurement
+   */
+  int64_t               fifoAccum[6];
+  uint32_t              fifoSamples;
+  WORD_ALIGNED_ATTR uint8_t fifoBuffer[2][IMU_FIFO_BURST_SIZE];
+
+  /**
+   * Descriptor of the queued FIFO burst. It's a member (like the buffers) so
+   * that it outlives drainFIFO() if an error leaves a transfer in flight,
+   * which is then collected by the next drain (`fifoPending`)
+   */
+  spi_transaction_t     fifoTrans;
+  bool                  fifoPending;
+
+  /**
+   * Orientation filter, fed with every FIFO sample
+   */
+  MadgwickAHRS          ahrs;
+  mpud::float_axes_t    burstAccel[IMU_FIFO_BURST_SIZE / IMU_FIFO_PACKET_SIZE];
+  mpud::float_axes_t    burstGyro[IMU_FIFO_BURST_SIZE / IMU_FIFO_PACKET_SIZE];
+
+  /**
+   * Last heading computed while sampling at full rate. The compass is not
+   * read in wake-on-motion, so this is held until full-rate sampling resumes.
+   */
+  float                 heading;
+
+  /**
+   * `motionWake` if the motion threshold is in use (and the INT line is
+   * wired), `mpuConnected` once the MPU answered and was initialized
+   */
+  bool                  motionWake;
+  bool                  mpuConnected;
+
+  /**
+   * Wake-on-motion state: `motionArmed` while the MPU idles in low-power
+   * accel mode waiting for the motion interrupt, `motionTimer` while a
+   * motion episode is being sampled at full rate
+   */
+  bool                  motionArmed;
+  ModuleTimer_t         motionTimer;
+  ModuleTimer_t         drainTimer;
+
+  /**
+   * Configure the sample rate and route accel+gyro samples to the FIFO
+   */
+  esp_err_t startFIFO();
+
+  /**
+   * Read everything in the FIFO in bursts and accumulate it
+   */
+  esp_err_t drainFIFO();
+
+  /**
+   * Stop sampling and leave the MPU in low-power accel mode, raising the
+   * interrupt pin when the motion threshold is crossed
+   */
+  esp_err_t armWakeOnMotion();
+
+  /**
+   * Leave low-power mode and sample through the FIFO at full rate
+   */
+  esp_err_t startSampling();
+
+  /**
+   * Motion interrupt pin handler
+   */
+  static void IRAM_ATTR motionISR(void *arg);
+
 };
 
 
@@ -73,6 +73,13 @@ _ModuleNMEAParser::_ModuleNMEAParser()
 #define CONFIG_NMEA_STATEMENT_VTG 1
 #define CONFIG_NMEA_STATEMENT_RMC 1
 
+/**
+ * Packs the 3-letter NMEA sentence identifier into a single word so that the
+ * statement type is resolved with one switch instead of a chain of strstr()
+ */
+#define NMEA_SENTENCE_CODE(a, b, c) \
+    (((uint32_t)(uint8_t)(a) << 16) | ((uint32_t)(uint8_t)(b) << 8) | (uint32_t)(uint8_t)(c))
+
 
 /**
  * @brief parse latitude or longitude
@@ -387,40 +394,46 @@ static esp_err_t parse_item(esp_gps_t *esp_gps)
         esp_gps->parent.receiver[0] = esp_gps->item_str[1];
         esp_gps->parent.receiver[1] = esp_gps->item_str[2];
 
-        if (0) {
+        /* "$ttSSS": match the 3-letter sentence id as a single packed word */
+        uint32_t code = 0;
+        if (esp_gps->item_pos >= 6) {
+            code = NMEA_SENTENCE_CODE(esp_gps->item_str[3], esp_gps->item_str[4], esp_gps->item_str[5]);
         }
+
+        switch (code) {
 #if CONFIG_NMEA_STATEMENT_GGA
-        else if (strstr(esp_gps->item_str, "GGA")) {
+        case NMEA_SENTENCE_CODE('G', 'G', 'A'):
             esp_gps->cur_statement = STATEMENT_GGA;
-        }
+            break;
 #endif
 #if CONFIG_NMEA_STATEMENT_GSA
-        else if (strstr(esp_gps->item_str, "GSA")) {
+        case NMEA_SENTENCE_CODE('G', 'S', 'A'):
             esp_gps->cur_statement = STATEMENT_GSA;
-        }
+            break;
 #endif
 #if CONFIG_NMEA_STATEMENT_RMC
-        else if (strstr(esp_gps->item_str, "RMC")) {
+        case NMEA_SENTENCE_CODE('R', 'M', 'C'):
             esp_gps->cur_statement = STATEMENT_RMC;
-        }
+            break;
 #endif
 #if CONFIG_NMEA_STATEMENT_GSV
-        else if (strstr(esp_gps->item_str, "GSV")) {
+        case NMEA_SENTENCE_CODE('G', 'S', 'V'):
             esp_gps->cur_statement = STATEMENT_GSV;
-        }
+            break;
 #endif
 #if CONFIG_NMEA_STATEMENT_GLL
-        else if (strstr(esp_gps->item_str, "GLL")) {
+        case NMEA_SENTENCE_CODE('G', 'L', 'L'):
             esp_gps->cur_statement = STATEMENT_GLL;
-        }
+            break;
 #endif
 #if CONFIG_NMEA_STATEMENT_VTG
-        else if (strstr(esp_gps->item_str, "VTG")) {
+        case NMEA_SENTENCE_CODE('V', 'T', 'G'):
             esp_gps->cur_statement = STATEMENT_VTG;
-        }
+            break;
 #endif
-        else {
+        default:
             esp_gps->cur_statement = STATEMENT_UNKNOWN;
+            break;
         }
         goto out;
     }
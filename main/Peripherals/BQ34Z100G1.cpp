@@ -151,6 +151,24 @@ static esp_err_t _read_mem8(I2CInterface &iface, uint8_t addr, uint8_t *value) {
   return ESP_OK;
 }
 
+/**
+ * Select the flash subclass and block to access. DataFlashClass and
+ * DataFlashBlock are adjacent, so both are written in one transaction.
+ */
+static esp_err_t _select_block(I2CInterface &iface, uint8_t subclass, uint16_t block) {
+  uint8_t buf[3];
+  TRACE_LOGD(TAG, "Selecting subclass=0x%02x, block %d", subclass, block);
+
+  buf[0] = BQ34Z100G1_REG8_DFCLS;
+  buf[1] = subclass;
+  buf[2] = block & 0xFF;
+  return iface.i2cWrite(
+    BQ34Z100G1_ADDR,
+    &buf[0],
+    3
+  );
+}
+
 /**
  * Read arbitrary long segment of flash memory in the given pointer
  */
@@ -170,32 +188,14 @@ static esp_err_t _read_flash(I2CInterface &iface, uint8_t subclass, uint16_t off
   );
   if (err != ESP_OK) return err;
 
-  // Configure the subclass
-  buf[0] = BQ34Z100G1_REG8_DFCLS;
-  buf[1] = subclass;
-  err = iface.i2cWrite(
-    BQ34Z100G1_ADDR,
-    &buf[0],
-    2
-  );
-  if (err != ESP_OK) return err;
-
   // The flass is accessed in 32-byte blocks.
   // Find the first and the last block requested
   uint16_t firstBlock = offset / 32;
   uint16_t lastBlock = (offset + size) / 32;
   uint16_t b = 0;
   for (uint16_t block=firstBlock; block<=lastBlock; block++) {
-    TRACE_LOGD(TAG, "Selecting block %d", block);
-
-    // Select the block we want to read
-    buf[0] = BQ34Z100G1_REG8_DFBLK;
-    buf[1] = block & 0xFF;
-    err = iface.i2cWrite(
-      BQ34Z100G1_ADDR,
-      &buf[0],
-      2
-    );
+    // Select the block we want to access
+    err = _select_block(iface, subclass, block);
     if (err != ESP_OK) return err;
 
     uint8_t startOffset = offset % 32;
@@ -250,17 +250,6 @@ static esp_err_t _write_flash(I2CInterface &iface, uint8_t subclass, uint16_t of
   );
   if (err != ESP_OK) return err;
 
-  // Configure the subclass
-  buf[0] = BQ34Z100G1_REG8_DFCLS;
-  buf[1] = subclass;
-
-  err = iface.i2cWrite(
-    BQ34Z100G1_ADDR,
-    &buf[0],
-    2
-  );
-  if (err != ESP_OK) return err;
-
   // The flass is accessed in 32-byte blocks.
   // Find the first and the last block requested
   uint16_t firstBlock = offset / 32;
@@ -268,16 +257,8 @@ static esp_err_t _write_flash(I2CInterface &iface, uint8_t subclass, uint16_t of
   uint16_t b = 0;
   uint8_t csum = 0;
   for (uint16_t block=firstBlock; block<=lastBlock; block++) {
-    TRACE_LOGD(TAG, "Selecting block %d", block);
-
-    // Select the block we want to read
-    buf[0] = BQ34Z100G1_REG8_DFBLK;
-    buf[1] = block & 0xFF;
-    err = iface.i2cWrite(
-      BQ34Z100G1_ADDR,
-      &buf[0],
-      2
-    );
+    // Select the block we want to access
+    err = _select_block(iface, subclass, block);
     if (err != ESP_OK) return err;
 
     uint8_t startOffset = offset % 32;
@@ -359,7 +340,8 @@ static esp_err_t _write_flash(I2CInterface &iface, uint8_t subclass, uint16_t of
     TRACE_LOGD(TAG, "ret=%d", err);
     if (err != ESP_OK) return err;
 
-    // The data will be written when the correct checksum is sent
+    // The data will be written when the correct checksum is sent. The
+    // gauge expects it as a transaction of its own, after the data.
     buf[0] = BQ34Z100G1_REG8_DFDCKS;
     buf[1] = csum;
 
@@ -467,6 +449,21 @@ esp_err_t bq34z100g1_stateOfHealth(I2CInterface &iface, uint16_t *value) {
   return _read_mem16(iface, BQ34Z100G1_REG16_SOH, value);
 }
 
+esp_err_t bq34z100g1_standardData(I2CInterface &iface, bq34z100g1_standard_data *value) {
+  uint8_t addr = BQ34Z100G1_REG8_SOC;
+  TRACE_LOGD(TAG, "Reading standard commands 0x%02x-0x%02x", addr, BQ34Z100G1_REG16_CHGV - 1);
+
+  // The gauge auto-increments the command address, so all the standard
+  // commands can be read in a single transaction
+  return iface.i2cWriteRead(
+    BQ34Z100G1_ADDR,
+    &addr,
+    1,
+    (uint8_t*)value,
+    sizeof(bq34z100g1_standard_data)
+  );
+}
+
 esp_err_t bq34z100g1_deviceName(I2CInterface &iface, char* dst, size_t len) {
   if (len > 12) len = 12;
 
@@ -106,6 +106,37 @@ struct __attribute__((packed)) bq34z100g1_pack_config {
   uint8_t   soh_disp    : 1;
 };
 
+/**
+ * The standard command registers 0x02-0x2F, as read in one burst by
+ * `bq34z100g1_standardData`. All values are little-endian, like the CPU.
+ */
+struct __attribute__((packed)) bq34z100g1_standard_data {
+  uint8_t   soc;                  /**> 0x02 StateOfCharge (%) */
+  uint8_t   max_error;            /**> 0x03 MaxError (%) */
+  uint16_t  remaining_capacity;   /**> 0x04 RemainingCapacity (mAh) */
+  uint16_t  full_charge_capacity; /**> 0x06 FullChargeCapacity (mAh) */
+  uint16_t  voltage;              /**> 0x08 Voltage (mV) */
+  uint16_t  average_current;      /**> 0x0A AverageCurrent (mA) */
+  uint16_t  temperature;          /**> 0x0C Temperature (0.1ºK) */
+  uint16_t  flags;                /**> 0x0E Flags */
+  uint16_t  current;              /**> 0x10 Current (mA) */
+  uint16_t  flags_b;              /**> 0x12 FlagsB */
+  uint8_t   _reserved0[4];        /**> 0x14 */
+  uint16_t  average_time_to_empty;/**> 0x18 AverageTimeToEmpty (Minutes) */
+  uint16_t  average_time_to_full; /**> 0x1A AverageTimeToFull (Minutes) */
+  uint16_t  passed_charge;        /**> 0x1C PassedCharge (mAh) */
+  uint16_t  dod0_time;            /**> 0x1E DoD0Time (Minutes) */
+  uint8_t   _reserved1[4];        /**> 0x20 */
+  uint16_t  available_energy;     /**> 0x24 AvailableEnergy (10 mW/h) */
+  uint16_t  available_power;      /**> 0x26 AvailablePower (10 mW) */
+  uint16_t  serial_number;        /**> 0x28 Serial Number */
+  uint16_t  internal_temperature; /**> 0x2A Internal_Temperature (0.1°K) */
+  uint16_t  cycle_count;          /**> 0x2C CycleCount (Counts) */
+  uint16_t  soh;                  /**> 0x2E StateOfHealth */
+};
+static_assert(sizeof(bq34z100g1_standard_data) == BQ34Z100G1_REG16_CHGV - BQ34Z100G1_REG8_SOC,
+  "bq34z100g1_standard_data must map the registers 0x02-0x2F");
+
 /**
  * Device configuration
  */
@@ -125,6 +156,7 @@ esp_err_t bq34z100g1_voltage            (I2CInterface &iface, uint16_t *value);
 esp_err_t bq34z100g1_averageCurrent     (I2CInterface &iface, uint16_t *value);
 esp_err_t bq34z100g1_temperature        (I2CInterface &iface, uint16_t *value);
 esp_err_t bq34z100g1_stateOfHealth      (I2CInterface &iface, uint16_t *value);
+esp_err_t bq34z100g1_standardData       (I2CInterface &iface, bq34z100g1_standard_data *value);
 esp_err_t bq34z100g1_deviceName         (I2CInterface &iface, char* dst, size_t len);
 esp_err_t bq34z100g1_reset              (I2CInterface &iface);
 
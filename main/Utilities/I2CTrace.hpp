@@ -0,0 +1,44 @@
+#ifndef YACHTSENSE_I2C_TRACE
+#define YACHTSENSE_I2C_TRACE
+#include <stdint.h>
+
+/**
+ * Binary format of the I2C bus traces written by `I2CTraceRecorder` and
+ * consumed by `I2CTraceReplay`.
+ *
+ * A trace starts with an `i2c_trace_header`, followed by one record per bus
+ * transaction. Every record is an `i2c_trace_record`, followed by the
+ * `wr_len` bytes written and the `rd_len` bytes read. All fields are
+ * little-endian.
+ */
+
+#define I2C_TRACE_MAGIC       0x54433249  /**> "I2CT" */
+#define I2C_TRACE_VERSION     2
+
+/**
+ * The I2CInterface operations
+ */
+enum i2c_trace_op {
+  I2C_TRACE_WRITE       = 1,
+  I2C_TRACE_READ        = 2,
+  I2C_TRACE_WRITE_READ  = 3,
+  I2C_TRACE_RESET       = 4,
+};
+
+struct __attribute__((packed)) i2c_trace_header {
+  uint32_t  magic;
+  uint16_t  version;
+  uint16_t  _reserved;
+};
+
+struct __attribute__((packed)) i2c_trace_record {
+  uint64_t  timestamp;    /**> Start of the transaction (us since the trace started) */
+  uint16_t  duration;     /**> Time spent on the bus (us, saturated) */
+  uint8_t   op;           /**> One of `i2c_trace_op` */
+  uint8_t   address;      /**> 7-bit device address */
+  uint8_t   wr_len;
+  uint8_t   rd_len;
+  int16_t   err;          /**> The `esp_err_t` returned */
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include <cstring>
+
+#include "I2CTraceRecorder.hpp"
+#include "Modules/ModuleSDCard.hpp"
+#include "Sherlock.hpp"
+#include "esp_timer.h"
+
+static const char * TAG = "util.i2ctrace";
+
+/**
+ * Constructor
+ */
+I2CTraceRecorder::I2CTraceRecorder(I2CInterface &iface, const char * filename)
+  : iface(iface), filename(filename), recording(false), startTime(0), used(0) { }
+
+/**
+ * Create a new trace file and start recording
+ */
+esp_err_t I2CTraceRecorder::start() {
+  i2c_trace_header hdr = { I2C_TRACE_MAGIC, I2C_TRACE_VERSION, 0 };
+  esp_err_t err = ModuleSDCard.writeFile(filename, &hdr, sizeof(hdr));
+  if (err != ESP_OK) {
+    TRACE_LOGE(TAG, "Unable to create trace %s, error=%#X", filename, err);
+    return err;
+  }
+
+  TRACE_LOGI(TAG, "Recording I2C trace to %s", filename);
+  used = 0;
+  startTime = esp_timer_get_time();
+  recording = true;
+  return ESP_OK;
+}
+
+/**
+ * Flush the buffered records and stop recording
+ */
+esp_err_t I2CTraceRecorder::stop() {
+  esp_err_t err = flush();
+  recording = false;
+  return err;
+}
+
+/**
+ * Append the buffered records to the trace file
+ */
+esp_err_t I2CTraceRecorder::flush() {
+  if (!used) return ESP_OK;
+
+  esp_err_t err = ModuleSDCard.appendFile(filename, buffer, used);
+  if (err != ESP_OK) {
+    TRACE_LOGE(TAG, "Unable to write trace %s, error=%#X", filename, err);
+  }
+  used = 0;
+  return err;
+}
+
+/**
+ * Append a record to the buffer, flushing it first if it's full
+ */
+void I2CTraceRecorder::record(int64_t started, uint8_t op, uint8_t address, const uint8_t * wr_data, uint8_t wr_len,
+                              const uint8_t * rd_data, uint8_t rd_len, esp_err_t err) {
+  int64_t duration = esp_timer_get_time() - started;
+  size_t len = sizeof(i2c_trace_record) + wr_len + rd_len;
+  if (used + len > sizeof(buffer)) flush();
+
+  i2c_trace_record rec;
+  rec.timestamp = (uint64_t)(started - startTime);
+  rec.duration = duration > 0xFFFF ? 0xFFFF : (uint16_t)duration;
+  rec.op = op;
+  rec.address = address;
+  rec.wr_len = wr_len;
+  rec.rd_len = rd_len;
+  rec.err = (int16_t)err;
+
+  memcpy(&buffer[used], &rec, sizeof(rec));
+  used += sizeof(rec);
+  if (wr_len) memcpy(&buffer[used], wr_data, wr_len);
+  used += wr_len;
+  if (rd_len) memcpy(&buffer[used], rd_data, rd_len);
+  used += rd_len;
+}
+
+esp_err_t I2CTraceRecorder::i2cWrite(uint8_t address, uint8_t * data, uint8_t len) {
+  int64_t started = esp_timer_get_time();
+  esp_err_t err = iface.i2cWrite(address, data, len);
+  if (recording) record(started, I2C_TRACE_WRITE, address, data, len, NULL, 0, err);
+  return err;
+}
+
+esp_err_t I2CTraceRecorder::i2cRead(uint8_t address, uint8_t * data, uint8_t len) {
+  int64_t started = esp_timer_get_time();
+  esp_err_t err = iface.i2cRead(address, data, len);
+  if (recording) record(started, I2C_TRACE_READ, address, NULL, 0, data, data ? len : 0, err);
+  return err;
+}
+
+esp_err_t I2CTraceRecorder::i2cWriteRead(uint8_t address, uint8_t * wr_data, uint8_t wr_len, uint8_t * rd_data, uint8_t rd_len) {
+  int64_t started = esp_timer_get_time();
+  esp_err_t err = iface.i2cWriteRead(address, wr_data, wr_len, rd_data, rd_len);
+  if (recording) record(started, I2C_TRACE_WRITE_READ, address, wr_data, wr_len, rd_data, rd_len, err);
+  return err;
+}
+
+esp_err_t I2CTraceRecorder::i2cReset() {
+  int64_t started = esp_timer_get_time();
+  esp_err_t err = iface.i2cReset();
+  if (recording) record(started, I2C_TRACE_RESET, 0, NULL, 0, NULL, 0, err);
+  return err;
+}
@@ -0,0 +1,72 @@
+#ifndef YACHTSENSE_I2C_TRACE_RECORDER
+#define YACHTSENSE_I2C_TRACE_RECORDER
+#include "Interfaces/I2CInterface.hpp"
+#include "Utilities/I2CTrace.hpp"
+
+/**
+ * Size of the RAM buffer the records are collected in before they are
+ * appended to the trace file
+ */
+#define I2C_TRACE_BUFFER_SIZE   1024
+
+/**
+ * An I2CInterface decorator that forwards every transaction to the wrapped
+ * interface and records it, with its timing and data, in a trace file on the
+ * SD card (see `I2CTrace.hpp` for the format).
+ *
+ * Drivers are pointed to the recorder instead of the bus, eg:
+ *
+ *   I2CTraceRecorder trace(ModuleI2CExpander, "/sdcard/fg.i2c");
+ *   trace.start();
+ *   bq34z100g1_standardData(trace, &data);
+ *   trace.flush();
+ */
+class I2CTraceRecorder: public I2CInterface {
+public:
+
+  /**
+   * Constructor
+   *
+   * @param iface     The interface to record
+   * @param filename  The trace file on the SD card
+   */
+  I2CTraceRecorder(I2CInterface &iface, const char * filename);
+
+  /**
+   * Create a new trace file and start recording
+   */
+  esp_err_t start();
+
+  /**
+   * Flush the buffered records and stop recording
+   */
+  esp_err_t stop();
+
+  /**
+   * Append the buffered records to the trace file
+   */
+  esp_err_t flush();
+
+  virtual esp_err_t i2cWrite(uint8_t address, uint8_t * data, uint8_t len);
+  virtual esp_err_t i2cRead(uint8_t address, uint8_t * data, uint8_t len);
+  virtual esp_err_t i2cWriteRead(uint8_t address, uint8_t * wr_data, uint8_t wr_len, uint8_t * rd_data, uint8_t rd_len);
+  virtual esp_err_t i2cReset();
+
+private:
+
+  /**
+   * Append a record to the buffer, flushing it first if it's full
+   */
+  void record(int64_t started, uint8_t op, uint8_t address, const uint8_t * wr_data, uint8_t wr_len,
+              const uint8_t * rd_data, uint8_t rd_len, esp_err_t err);
+
+  I2CInterface &  iface;
+  const char *    filename;
+  bool            recording;
+  int64_t         startTime;
+  size_t          used;
+  uint8_t         buffer[I2C_TRACE_BUFFER_SIZE];
+
+};
+
+#endif
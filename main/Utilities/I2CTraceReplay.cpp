@@ -0,0 +1,84 @@
+#include <cstring>
+
+#include "I2CTraceReplay.hpp"
+
+/**
+ * Constructor
+ */
+I2CTraceReplay::I2CTraceReplay(const uint8_t * trace, size_t len)
+  : trace(trace), len(len), pos(sizeof(i2c_trace_header)), failed(0), elapsed(0) { }
+
+/**
+ * Returns `true` if the trace header is valid
+ */
+bool I2CTraceReplay::isValid() const {
+  i2c_trace_header hdr;
+  if (len < sizeof(hdr)) return false;
+  memcpy(&hdr, trace, sizeof(hdr));
+  return (hdr.magic == I2C_TRACE_MAGIC) && (hdr.version == I2C_TRACE_VERSION);
+}
+
+/**
+ * Returns `true` when all the records were replayed
+ */
+bool I2CTraceReplay::isComplete() const {
+  return pos >= len;
+}
+
+/**
+ * Number of calls that did not match the trace
+ */
+size_t I2CTraceReplay::mismatches() const {
+  return failed;
+}
+
+/**
+ * Time the replayed transactions took when they were recorded (us)
+ */
+uint64_t I2CTraceReplay::busTime() const {
+  return elapsed;
+}
+
+/**
+ * Match the next record and return the recorded result
+ */
+esp_err_t I2CTraceReplay::replay(uint8_t op, uint8_t address, const uint8_t * wr_data, uint8_t wr_len,
+                                 uint8_t * rd_data, uint8_t rd_len) {
+  i2c_trace_record rec;
+  if (!isValid() || (pos + sizeof(rec) > len)) {
+    failed++;
+    return ESP_ERR_INVALID_STATE;
+  }
+  memcpy(&rec, &trace[pos], sizeof(rec));
+
+  const uint8_t * rec_wr = &trace[pos + sizeof(rec)];
+  const uint8_t * rec_rd = rec_wr + rec.wr_len;
+  if ((rec_rd + rec.rd_len > trace + len) ||
+      (rec.op != op) || (rec.address != address) ||
+      (rec.wr_len != wr_len) || (rec.rd_len != (rd_data ? rd_len : 0)) ||
+      (wr_len && memcmp(rec_wr, wr_data, wr_len))) {
+    failed++;
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  if (rec.rd_len) memcpy(rd_data, rec_rd, rec.rd_len);
+  pos += sizeof(rec) + rec.wr_len + rec.rd_len;
+  elapsed += rec.duration;
+  return rec.err;
+}
+
+esp_err_t I2CTraceReplay::i2cWrite(uint8_t address, uint8_t * data, uint8_t len) {
+  return replay(I2C_TRACE_WRITE, address, data, len, NULL, 0);
+}
+
+esp_err_t I2CTraceReplay::i2cRead(uint8_t address, uint8_t * data, uint8_t len) {
+  return replay(I2C_TRACE_READ, address, NULL, 0, data, len);
+}
+
+esp_err_t I2CTraceReplay::i2cWriteRead(uint8_t address, uint8_t * wr_data, uint8_t wr_len, uint8_t * rd_data, uint8_t rd_len) {
+  return replay(I2C_TRACE_WRITE_READ, address, wr_data, wr_len, rd_data, rd_len);
+}
+
+esp_err_t I2CTraceReplay::i2cReset() {
+  return replay(I2C_TRACE_RESET, 0, NULL, 0, NULL, 0);
+}
@@ -0,0 +1,70 @@
+#ifndef YACHTSENSE_I2C_TRACE_REPLAY
+#define YACHTSENSE_I2C_TRACE_REPLAY
+#include "Interfaces/I2CInterface.hpp"
+#include "Utilities/I2CTrace.hpp"
+
+/**
+ * An I2CInterface that plays back a trace recorded by `I2CTraceRecorder`,
+ * so that drivers can run off-device against real bus traffic.
+ *
+ * Every call is matched against the next record: the operation, address and
+ * the bytes written must be the same, in which case the recorded read data
+ * and error are returned. Anything else is counted as a mismatch and fails
+ * with `ESP_ERR_INVALID_STATE`. Transactions complete immediately, the time
+ * they took on the device is accumulated in `busTime()`.
+ *
+ * Only depends on `I2CInterface`, it does not touch any peripheral or module.
+ */
+class I2CTraceReplay: public I2CInterface {
+public:
+
+  /**
+   * Constructor
+   *
+   * @param trace  The trace contents, including the header
+   * @param len    The size of the trace
+   */
+  I2CTraceReplay(const uint8_t * trace, size_t len);
+
+  /**
+   * Returns `true` if the trace header is valid
+   */
+  bool isValid() const;
+
+  /**
+   * Returns `true` when all the records were replayed
+   */
+  bool isComplete() const;
+
+  /**
+   * Number of calls that did not match the trace
+   */
+  size_t mismatches() const;
+
+  /**
+   * Time the replayed transactions took when they were recorded (us)
+   */
+  uint64_t busTime() const;
+
+  virtual esp_err_t i2cWrite(uint8_t address, uint8_t * data, uint8_t len);
+  virtual esp_err_t i2cRead(uint8_t address, uint8_t * data, uint8_t len);
+  virtual esp_err_t i2cWriteRead(uint8_t address, uint8_t * wr_data, uint8_t wr_len, uint8_t * rd_data, uint8_t rd_len);
+  virtual esp_err_t i2cReset();
+
+private:
+
+  /**
+   * Match the next record and return the recorded result
+   */
+  esp_err_t replay(uint8_t op, uint8_t address, const uint8_t * wr_data, uint8_t wr_len,
+                   uint8_t * rd_data, uint8_t rd_len);
+
+  const uint8_t * trace;
+  size_t          len;
+  size_t          pos;
+  size_t          failed;
+  uint64_t        elapsed;
+
+};
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef YACHTSENSE_INDEXED_DOT_MATRIX
+#define YACHTSENSE_INDEXED_DOT_MATRIX
+
+#include "DotConfig/dotconfig/matrix.hpp"
+
+/**
+ * Matrix storage with a static stack buffer, like `DotMatrix`, that keeps
+ * track of its write cursor and element count so appending is O(1).
+ *
+ * If INDEX_SZ is non-zero, the offsets of the first INDEX_SZ elements are also
+ * kept, making `get` O(1) for them. Elements past the index are located by
+ * scanning forward from the last indexed element.
+ *
+ * This is a separate type so that the `DotMatrix` layout used by the kernel
+ * library stays untouched.
+ */
+template <uint16_t STORAGE_SZ, uint16_t INDEX_SZ = 0>
+struct IndexedDotMatrix: public DotMatrixInterface {
+private:
+
+  char      buffer[STORAGE_SZ];
+
+  /**
+   * Offset of the beginning of the final double-NULL characters that denote
+   * the end of the buffer.
+   */
+  uint16_t  tail;
+
+  /**
+   * Number of elements in the buffer
+   */
+  uint16_t  count;
+
+  /**
+   * Offsets of the first INDEX_SZ elements
+   */
+  uint16_t  offsets[INDEX_SZ ? INDEX_SZ : 1];
+
+public:
+
+  IndexedDotMatrix() {
+    memset(buffer, 0, STORAGE_SZ);
+    tail = 0;
+    count = 0;
+  }
+
+  DotMatrixInterface::iterator nappend(const char * data, size_t len) {
+    size_t used = (size_t)tail + 1; // (plus tailing null char)
+    size_t remains = STORAGE_SZ - used - 1;
+
+    // Check if this actions is going to overrun the buffer
+    if ((len + 1) > remains) {
+      return DotMatrixInterface::iterator(NULL);
+    }
+
+    // Empty strings cannot be stored, since they would read as the ending
+    if (len == 0) {
+      return DotMatrixInterface::iterator(&buffer[tail]);
+    }
+
+    // Advance past the previous NULL termination, otherwise we are going
+    // to append to the previous string
+    char * dst = &buffer[tail];
+    if (count > 0) dst++;
+
+    // Copy data & mark the new ending
+    memcpy(dst, data, len);
+    dst[len] = '\0';
+    dst[len+1] = '\0';
+
+    if (count < INDEX_SZ) {
+      offsets[count] = (uint16_t)(dst - &buffer[0]);
+    }
+    tail = (uint16_t)(dst - &buffer[0] + len);
+    count++;
+
+    return DotMatrixInterface::iterator(dst);
+  }
+
+  virtual DotMatrixInterface::iterator append(const char * str) {
+    return nappend(str, strlen(str));
+  }
+
+  virtual rows_iterator beginRows(const uint8_t cols) {
+    return DotMatrixInterface::rows_iterator(buffer, cols);
+  }
+
+  virtual DotMatrixInterface::iterator begin() {
+    return DotMatrixInterface::iterator(buffer);
+  }
+
+  virtual DotMatrixInterface::iterator end() {
+    return DotMatrixInterface::iterator(&buffer[tail]);
+  }
+
+  virtual void clear() {
+    buffer[0] = '\0';
+    buffer[1] = '\0';
+    tail = 0;
+    count = 0;
+  }
+
+  /**
+   * Number of elements in the matrix
+   */
+  uint16_t size() const {
+    return count;
+  }
+
+  /**
+   * Element accessor by flat index
+   * (O(1) for the indexed elements, O(N) past them)
+   */
+  const char * get(const int index) const {
+    if ((index < 0) || (index >= count)) return NULL;
+    if (index < INDEX_SZ) return &buffer[offsets[index]];
+
+    // Scan forward from the last indexed element
+    int i = 0;
+    const char * ptr = buffer;
+    if (INDEX_SZ > 0) {
+      i = INDEX_SZ - 1;
+      ptr = &buffer[offsets[i]];
+    }
+    for (; i < index; ++i) {
+      ptr += strlen(ptr) + 1;
+    }
+    return ptr;
+  }
+
+  /**
+   * Element accessor for a matrix with `cols` columns
+   */
+  const char * get(const int col, const int row, const uint8_t cols) const {
+    if ((cols == 0) || (col < 0) || (col >= cols) || (row < 0)) return NULL;
+    return get(row * cols + col);
+  }
+
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include "MadgwickAHRS.hpp"
+#include <math.h>
+
+static const float RAD_TO_DEG = 180.0f / M_PI;
+
+/**
+ * Wrap an angle in degrees to [0, 360)
+ */
+static float wrapDegrees(float deg) {
+  deg = fmodf(deg, 360.0f);
+  return deg < 0 ? deg + 360.0f : deg;
+}
+
+/**
+ * Constructor
+ */
+MadgwickAHRS::MadgwickAHRS(float beta)
+  : beta(beta), q{1.0f, 0.0f, 0.0f, 0.0f}, initialized(false)
+{ }
+
+/**
+ * Forget the current orientation
+ */
+void MadgwickAHRS::reset() {
+  q[0] = 1.0f;
+  q[1] = q[2] = q[3] = 0.0f;
+  initialized = false;
+}
+
+/**
+ * Feed one sample
+ */
+void MadgwickAHRS::update(float gx, float gy, float gz, float ax, float ay, float az, float dt) {
+  float q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+  float norm = ax * ax + ay * ay + az * az;
+
+  // Start from the orientation of the gravity vector instead of converging
+  // to it from identity, which would take several seconds
+  if (!initialized) {
+    if (norm == 0.0f) return;
+    float roll = atan2f(ay, az) * 0.5f;
+    float pitch = atan2f(-ax, sqrtf(ay * ay + az * az)) * 0.5f;
+    q[0] = cosf(roll) * cosf(pitch);
+    q[1] = sinf(roll) * cosf(pitch);
+    q[2] = cosf(roll) * sinf(pitch);
+    q[3] = -sinf(roll) * sinf(pitch);
+    initialized = true;
+    return;
+  }
+
+  // Rate of change of the quaternion from the gyroscope
+  float qDot0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+  float qDot1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+  float qDot2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+  float qDot3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+  // Gradient descent step towards the measured gravity (skipped in free fall)
+  if (norm > 0.0f) {
+    float recip = 1.0f / sqrtf(norm);
+    ax *= recip;
+    ay *= recip;
+    az *= recip;
+
+    float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+    float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+    float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+    float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+    float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+    float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+    float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+    float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+
+    norm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+    if (norm > 0.0f) {
+      recip = beta / sqrtf(norm);
+      qDot0 -= s0 * recip;
+      qDot1 -= s1 * recip;
+      qDot2 -= s2 * recip;
+      qDot3 -= s3 * recip;
+    }
+  }
+
+  // Integrate and normalize
+  q0 += qDot0 * dt;
+  q1 += qDot1 * dt;
+  q2 += qDot2 * dt;
+  q3 += qDot3 * dt;
+
+  float recip = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+  q[0] = q0 * recip;
+  q[1] = q1 * recip;
+  q[2] = q2 * recip;
+  q[3] = q3 * recip;
+}
+
+/**
+ * Roll around the X axis in degrees
+ */
+float MadgwickAHRS::heel() const {
+  return atan2f(2.0f * (q[0] * q[1] + q[2] * q[3]), 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2])) * RAD_TO_DEG;
+}
+
+/**
+ * Rotation around the Y axis in degrees
+ */
+float MadgwickAHRS::pitch() const {
+  float s = 2.0f * (q[0] * q[2] - q[3] * q[1]);
+  if (s > 1.0f) s = 1.0f;
+  if (s < -1.0f) s = -1.0f;
+  return asinf(s) * RAD_TO_DEG;
+}
+
+/**
+ * Gyro-integrated rotation around the Z axis in degrees
+ */
+float MadgwickAHRS::yaw() const {
+  return wrapDegrees(atan2f(2.0f * (q[0] * q[3] + q[1] * q[2]), 1.0f - 2.0f * (q[2] * q[2] + q[3] * q[3])) * RAD_TO_DEG);
+}
+
+/**
+ * Tilt-compensated magnetic heading in degrees
+ */
+float MadgwickAHRS::heading(float mx, float my, float mz) const {
+  float roll = heel() / RAD_TO_DEG;
+  float pitch = this->pitch() / RAD_TO_DEG;
+
+  // Project the field on the horizontal plane
+  float xh = mx * cosf(pitch) + my * sinf(roll) * sinf(pitch) + mz * cosf(roll) * sinf(pitch);
+  float yh = my * cosf(roll) - mz * sinf(roll);
+  return wrapDegrees(atan2f(-yh, xh) * RAD_TO_DEG);
+}
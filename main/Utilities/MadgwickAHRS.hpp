@@ -0,0 +1,73 @@
+#ifndef YACHTSENSE_MADGWICK_AHRS
+#define YACHTSENSE_MADGWICK_AHRS
+
+/**
+ * Attitude and heading reference system based on Madgwick's gradient descent
+ * orientation filter (IMU variant).
+ *
+ * The gyroscope is integrated at the sensor rate and the drift is corrected
+ * towards the gravity vector measured by the accelerometer. This gives stable
+ * heel and pitch angles; heading needs an absolute reference and is taken from
+ * a tilt-compensated magnetometer reading when one is available.
+ *
+ * Cost is a fixed ~120 float operations and three square roots per sample
+ * (normalizing the accelerometer, the gradient step and the quaternion).
+ */
+class MadgwickAHRS {
+public:
+
+  /**
+   * Constructor
+   *
+   * @param beta  Filter gain, higher values trust the accelerometer more
+   */
+  MadgwickAHRS(float beta = 0.1f);
+
+  /**
+   * Forget the current orientation, the next sample re-initializes it
+   */
+  void reset();
+
+  /**
+   * Feed one sample
+   *
+   * @param gx,gy,gz  Angular rate in rad/s
+   * @param ax,ay,az  Acceleration in any unit (only the direction is used)
+   * @param dt        Time since the previous sample in seconds
+   */
+  void update(float gx, float gy, float gz, float ax, float ay, float az, float dt);
+
+  /**
+   * Orientation quaternion {w, x, y, z}
+   */
+  const float * quaternion() const { return q; }
+
+  /**
+   * Roll around the X (longitudinal) axis in degrees
+   */
+  float heel() const;
+
+  /**
+   * Rotation around the Y (transverse) axis in degrees
+   */
+  float pitch() const;
+
+  /**
+   * Gyro-integrated rotation around the Z axis in degrees [0, 360), this is
+   * relative to the orientation at start-up and drifts over time
+   */
+  float yaw() const;
+
+  /**
+   * Heading in degrees [0, 360) from a magnetometer reading expressed in the
+   * same axes as the accelerometer, compensated for the current heel and pitch
+   */
+  float heading(float mx, float my, float mz) const;
+
+private:
+  float beta;
+  float q[4];
+  bool  initialized;
+};
+
+#endif
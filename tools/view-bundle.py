@@ -632,6 +632,7 @@ class Bundle:
     self.releases = releases
     self.defaultElf = defaultElf
     self.sections = []
+    self.raw = None
     self.section_handlers = [
       SysInfoSection,
       FirmwareSection,
@@ -646,7 +647,7 @@ class Bundle:
   def _loadSectionV1(self, buf):
     (magic, s_type, s_ver, size) = struct.unpack("<HBBI", buf[0:8])
     if magic != 0xA5A5:
-      hexdump.hexdump(buf)
+      hexdump.hexdump(bytes(buf))
       raise IOError("Unexpected section magic")
 
     if s_type >= len(self.section_handlers):
@@ -654,21 +655,21 @@ class Bundle:
     else:
       SectionClass = self.section_handlers[s_type]
 
-    section = SectionClass(self, s_type, s_ver, buf[8:8+size])
+    section = SectionClass(self, s_type, s_ver, bytes(buf[8:8+size]))
     self.sections.append(section)
 
     return size + 8
 
-  def _findNextSectionV1(self, buf):
-    for i in range(0, len(buf) - 1):
-      if buf[i] == 0xA5 and buf[i+1] == 0xA5:
-        return i
-    return None
+  def _findNextSectionV1(self, start):
+    i = self.raw.find(b'\xA5\xA5', start)
+    if i < 0:
+      return None
+    return i - start
 
-  def _loadSectionV2(self, buf):
+  def _loadSectionV2(self, buf, base):
     (magic, size, s_type, s_ver) = struct.unpack("<IIBB", buf[0:10])
     if magic != 0xA5A55A5A:
-      hexdump.hexdump(buf)
+      hexdump.hexdump(bytes(buf))
       raise IOError("Unexpected section start magic")
 
     print("found={:02x}.{} (sz={})".format(s_type, s_ver, size))
@@ -677,12 +678,12 @@ class Bundle:
     footer = buf[12+size:12+size+8]
     if len(footer) < 8:
       print("ERROR: Premature ending of section 0x{:02x}.{:d} ".format(s_type, s_ver))
-      ofs = self._findNextSectionV2(buf[4:])
+      ofs = self._findNextSectionV2(base + 4)
       if ofs == None:
         ofs = len(buf)
       size = ofs - 8 # Footer
 
-      for line in hexdump.dumpgen(buf):
+      for line in hexdump.dumpgen(bytes(buf)):
         print("        ", line)
 
       # Compute new footer
@@ -696,7 +697,7 @@ class Bundle:
       print("ERROR: Invalid ending of section 0x{:02x}.{:d}, data might be junk ".format(s_type, s_ver))
 
     # Extract data
-    data = buf[12:12+size]
+    data = bytes(buf[12:12+size])
     if zlib.crc32(data) != crc:
       print("ERROR: Section 0x{:02x}.{:d} CRC mismatch".format(s_type, s_ver))
 
@@ -710,12 +711,11 @@ class Bundle:
 
     return size + 12 + 8
 
-  def _findNextSectionV2(self, buf, bt=(0xA5, 0xA5, 0x5A, 0x5A)):
-    for i in range(0, len(buf) - 4):
-      if buf[i] == bt[0] and buf[i+1] == bt[1] and \
-         buf[i+2] == bt[2] and buf[i+3] == bt[3]:
-        return i
-    return None
+  def _findNextSectionV2(self, start, bt=b'\xA5\xA5\x5A\x5A'):
+    i = self.raw.find(bt, start)
+    if i < 0:
+      return None
+    return i - start
 
   def load(self, filename):
     with open(filename, 'rb') as f:
@@ -727,6 +727,12 @@ class Bundle:
       if version > 2:
         raise IOError("Unsuported bundle version {}".format(version))
 
+      # Sections are parsed through a view on the file contents, so that
+      # walking a large bundle does not copy its remaining tail every time.
+      # Resynchronizing searches the file contents in place.
+      self.raw = bt
+      bt = memoryview(bt)
+
       if version == 1:
         # In version 1 (Before 1.1.249) we have a 16-bit section magic
         # and no section footer
@@ -735,7 +741,7 @@ class Bundle:
           diff = self._loadSectionV1(bt[ofs:])
           if ofs + diff > len(bt):
             print("ERROR: Section range out of bounds, locating next section")
-            end = self._findNextSectionV1(bt[ofs+2:])
+            end = self._findNextSectionV1(ofs+2)
             if end == None:
               ofs = len(bt)
             else:
@@ -748,10 +754,10 @@ class Bundle:
         # and a section footer with a CRC value
         ofs = 8
         while ofs < len(bt):
-          diff = self._loadSectionV2(bt[ofs:])
+          diff = self._loadSectionV2(bt[ofs:], ofs)
           if ofs + diff > len(bt):
             print("ERROR: Section range out of bounds, locating next section")
-            end = self._findNextSectionV2(bt[ofs+2:])
+            end = self._findNextSectionV2(ofs+2)
             if end == None:
               ofs = len(bt)
             else: